@@ -3,6 +3,18 @@
 #include <boost/numeric/ublas/vector.hpp>
 #include <boost/numeric/ublas/storage.hpp>
 #include "data_frame_col.hpp"
+#include "data_frame_selection.hpp"
+#include "data_frame_predicate.hpp"
+#include "data_frame_expression.hpp"
+#include "data_frame_index.hpp"
+#include "data_frame_sort.hpp"
+#include "data_frame_join.hpp"
+#include "data_frame_aggregate.hpp"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <optional>
 #include <list>
 #include <string>
 #include <unordered_map>
@@ -82,15 +94,17 @@ auto make_from_tuples(const std::vector<std::tuple<InnerTypes...>>& t, const std
     TypeLists<InnerTypes...>) {
     using type_collection = typename type_list<InnerTypes...>::types;
     assert(sizeof...(InnerTypes) == names.size());
-    int cur_rows = t.size();
+    row_id_t cur_rows = t.size();
     auto df = new data_frame(cur_rows, type_collection{});
-    df->init_columns(t[0], names, cur_rows);
-    for (int i = 0; i < cur_rows; i++)
+    df->init_columns(t.empty() ? std::tuple<InnerTypes...>{} : t[0], names, cur_rows);
+    for (row_id_t i = 0; i < cur_rows; i++)
         df->from_tuple(t[i], names, i);
     return df;
 }
 template<class... Types>
 class data_frame_view;
+template<class... Types>
+class data_frame_group_by;
 
 /** @brief data_frame represents a collection of data_frame_col, and it's designed as a heterogenous container. 
  * each data_frame_col can represent only one type 
@@ -143,6 +157,8 @@ public:
         auto iter = vals.insert(vals.end(), dfc);
         col_names_map.insert({col_name, iter});
         type_map.insert({col_name, typeid(T).name()});
+        get_zone_map<T>(col_name);
+        verify_sorted<T>(col_name);
     }
     /** @brief add tuples with colname @code names @endcode
     *
@@ -194,6 +210,206 @@ public:
     */   
     template<typename T>
     const T& get_c(const std::string& col_name, size_t pos) const;
+    /** @brief return the underlying container of column col_name, nullptr if it doesn't exist or has another type
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    const typename data_frame_col::store_type<T>* get_column(const std::string& col_name) const {
+        auto iter = col_names_map.find(col_name);
+        if (iter == col_names_map.end()) return nullptr;
+        auto type_iter = type_map.find(col_name);
+        if (type_iter == type_map.end() || type_iter->second != typeid(T).name()) return nullptr;
+        const data_frame_col& container = *(iter->second);
+        return &(container.data_frame_col::template get_vector<T>());
+    }
+    /** @brief return the per-block min/max statistics of an arithmetic column, nullptr for other columns
+    *
+    * The statistics are built when the column is loaded and rebuilt on first use after the column changed,
+    * e.g. by @code apply_with_index @endcode.
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    const zone_map<T>* get_zone_map(const std::string& col_name) const {
+        if constexpr (!std::is_arithmetic_v<T>) {
+            return nullptr;
+        } else {
+            const auto* tmp_vector = get_column<T>(col_name);
+            if (!tmp_vector || !tmp_vector->size()) return nullptr;
+            const data_frame_col& container = *(col_names_map.find(col_name)->second);
+            auto& zones = std::get<zone_map_store_t<T>>(zone_maps)[col_name];
+            if (!zones.valid || zones.version != container.version || zones.rows != tmp_vector->size())
+                zones.build(&(*tmp_vector)[0], tmp_vector->size(), container.version);
+            return &zones;
+        }
+    }
+    /** @brief build a secondary index on column col_name, owned by the data_frame
+    *
+    * The index is rebuilt on first use after the column changed, e.g. by @code apply_with_index @endcode.
+    * @code select @endcode answers equality and @code in @endcode predicates from any index and range predicates
+    * from sorted indexes, the joins use an index on the build side instead of building their own.
+    * A bitmap index is kept next to a hash or sorted one, filter expressions made only of conditions on
+    * bitmap-indexed columns are answered from the bitmaps.
+    *
+    * @tparam T the type for col_name column 
+    *
+    * @param col_name the column to index
+    *
+    * @param kind @code index_kind::hash @endcode, @code index_kind::sorted @endcode or @code index_kind::bitmap @endcode
+    */   
+    template<typename T>
+    bool create_index(const std::string& col_name, index_kind kind = index_kind::hash) {
+        static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+        if (!get_column<T>(col_name)) return false;
+        if (kind == index_kind::bitmap) {
+            std::get<bitmap_store_t<T>>(bitmap_indexes).insert_or_assign(col_name, bitmap_index<T>());
+            get_bitmap_index<T>(col_name);
+            return true;
+        }
+        std::get<index_store_t<T>>(indexes).insert_or_assign(col_name, column_index<T>(kind));
+        get_index<T>(col_name);
+        return true;
+    }
+    /** @brief remove the secondary indexes on column col_name, bitmap index included
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    bool drop_index(const std::string& col_name) {
+        size_t n = std::get<index_store_t<T>>(indexes).erase(col_name);
+        n += std::get<bitmap_store_t<T>>(bitmap_indexes).erase(col_name);
+        return n > 0;
+    }
+    /** @brief return the bitmap index on column col_name, nullptr if there is none
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    const bitmap_index<T>* get_bitmap_index(const std::string& col_name) const {
+        auto& store = std::get<bitmap_store_t<T>>(bitmap_indexes);
+        auto iter = store.find(col_name);
+        if (iter == store.end()) return nullptr;
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector) return nullptr;
+        size_t col_version = col_names_map.find(col_name)->second->version;
+        auto& index = iter->second;
+        if (!index.valid || index.version != col_version || index.size != tmp_vector->size())
+            index.build(tmp_vector->size() ? &(*tmp_vector)[0] : nullptr, tmp_vector->size(), col_version);
+        return &index;
+    }
+    /** @brief return the secondary index on column col_name, nullptr if there is none
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    const column_index<T>* get_index(const std::string& col_name) const {
+        auto& store = std::get<index_store_t<T>>(indexes);
+        auto iter = store.find(col_name);
+        if (iter == store.end()) return nullptr;
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector) return nullptr;
+        size_t col_version = col_names_map.find(col_name)->second->version;
+        auto& index = iter->second;
+        if (!index.valid || index.version != col_version || index.size != tmp_vector->size())
+            index.build(tmp_vector->size() ? &(*tmp_vector)[0] : nullptr, tmp_vector->size(), col_version);
+        return &index;
+    }
+    /** @brief return the secondary index on column col_name, or build a temporary sorted one into scratch
+    *
+    * @tparam T the type for col_name column 
+    *
+    * @param col_name the indexed column
+    *
+    * @param scratch storage for the temporary index
+    */   
+    template<typename T>
+    const column_index<T>& lookup_index(const std::string& col_name, column_index<T>& scratch) const {
+        if (const auto* index = get_index<T>(col_name)) return *index;
+        const auto* tmp_vector = get_column<T>(col_name);
+        size_t len = tmp_vector ? tmp_vector->size() : 0;
+        scratch = column_index<T>(index_kind::sorted);
+        scratch.build(len ? &(*tmp_vector)[0] : nullptr, len, 0);
+        return scratch;
+    }
+    /** @brief return the known order of column col_name, @code sort_order::none @endcode when it's unsorted,
+    * unknown or changed since it was checked
+    * 
+    * The order is recorded by the loaders, @code sort_copy @endcode, @code copy_with_range @endcode,
+    * @code append_tuples @endcode, @code verify_sorted @endcode and @code declare_sorted @endcode.
+    */   
+    sort_order get_sort_order(const std::string& col_name) const {
+        auto iter = sortedness.find(col_name);
+        auto col_iter = col_names_map.find(col_name);
+        if (iter == sortedness.end() || col_iter == col_names_map.end()) return sort_order::none;
+        if (iter->second.second != col_iter->second->version) return sort_order::none;
+        return iter->second.first;
+    }
+    /** @brief check the order of column col_name and record it
+    *
+    * @tparam T the type for col_name column 
+    */   
+    template<typename T>
+    sort_order verify_sorted(const std::string& col_name) {
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector) return sort_order::none;
+        sort_order order = detect_sort_order(tmp_vector->size() ? &(*tmp_vector)[0] : nullptr, tmp_vector->size());
+        sortedness[col_name] = {order, col_names_map.find(col_name)->second->version};
+        return order;
+    }
+    /** @brief record that column col_name is sorted without checking it, e.g. for data loaded from a sorted source
+    *
+    * The caller vouches for the order, operators relying on it like the merge join give wrong results otherwise.
+    * The record is dropped when the column changes.
+    *
+    * @param col_name the column name
+    *
+    * @param order the order of the column
+    */
+    void declare_sorted(const std::string& col_name, sort_order order) {
+        auto iter = col_names_map.find(col_name);
+        if (iter == col_names_map.end()) return;
+        sortedness[col_name] = {order, iter->second->version};
+    }
+    /** @brief copy a new data_frame with rows sorted by column col_name, the copy knows the column is sorted
+    *
+    * @tparam T the type for col_name column 
+    *
+    * @param col_name the column to sort by
+    *
+    * @param ascending smallest value first when true
+    *
+    * @note col_name must be a column of type T, this is asserted
+    */   
+    template<typename T>
+    data_frame<Types...> sort_copy(const std::string& col_name, bool ascending = true) {
+        static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+        static_assert(normalized_keys::is_supported_v<T>, "sort_copy needs an arithmetic or string column");
+        size_t len = cur_rows > 0 ? cur_rows : 0;
+        normalized_keys normalized(len);
+        bool found = add_sort_column<T>(normalized, sort_key(col_name, ascending));
+        assert(found);
+        auto new_df = copy_with_index(found ? normalized.argsort(true, default_thread_pool()) : std::vector<row_id_t>{});
+        new_df.template verify_sorted<T>(col_name);
+        return new_df;
+    }
+    /** @brief append rows to every column, the recorded order of a column is kept when the new rows extend it
+    *
+    * @tparam InnerTypes... The type for tuple, each InnerTypes must be the type of the named column
+    * 
+    * @param t vector of tuples to append
+    * 
+    * @param names column name for each tuple type, every column must be named
+    */   
+    template<class... InnerTypes>
+    bool append_tuples(const std::vector<std::tuple<InnerTypes...>>& t, const std::vector<std::string>& names) {
+        if (sizeof...(InnerTypes) != names.size() || names.size() != col_names_map.size()) return false;
+        if (!has_columns<InnerTypes...>(names, std::index_sequence_for<InnerTypes...>{})) return false;
+        if (t.empty()) return true;
+        append_columns(t, names, std::index_sequence_for<InnerTypes...>{});
+        cur_rows = (cur_rows > 0 ? cur_rows : 0) + t.size();
+        return true;
+    }
     /** @brief create a view only contains first n lines
     * 
     * @param n first n lines
@@ -222,9 +438,114 @@ public:
     */   
     template<typename Col_type, typename F>
     data_frame_view<Types...> select(const std::string& col_name, F f) {
-        const std::vector<int>& new_order = filter<Col_type>(col_name, f);
+        // range predicates on a sorted column select one run of rows, found by binary search
+        if constexpr (is_range_predicate<F>::value) {
+            sort_order order = get_sort_order(col_name);
+            const auto* tmp_vector = get_column<Col_type>(col_name);
+            if (order != sort_order::none && tmp_vector && tmp_vector->size()) {
+                auto r = sorted_range(&(*tmp_vector)[0], tmp_vector->size(), order, f);
+                return create_view_with_range(range(r.first, r.second));
+            }
+        }
+        const std::vector<row_id_t>& new_order = filter<Col_type>(col_name, f);
         return create_view_with_index(std::move(new_order));
     }
+    /** @brief create a view with rows only satisfying a condition, evaluated on a thread pool
+    * 
+    * @tparam Col_type the column type to be filtered
+    * 
+    * @tparam F a built-in predicate or a functor for condition, it's called concurrently
+    * 
+    * @param col_name the column name applying the condition
+    * 
+    * @param f a functor for condition
+    * 
+    * @param pool the threads to run on
+    */   
+    template<typename Col_type, typename F>
+    data_frame_view<Types...> parallel_select(const std::string& col_name, F f, thread_pool& pool = default_thread_pool()) {
+        return create_view_with_index(parallel_filter<Col_type>(col_name, f, pool));
+    }
+    /** @brief create a view with rows satisfying a filter expression, evaluated on a thread pool
+    * 
+    * @tparam E the filter expression type
+    * 
+    * @param e the filter expression
+    * 
+    * @param pool the threads to run on
+    */   
+    template<typename E, typename = std::enable_if_t<is_filter_expression_v<E>>>
+    data_frame_view<Types...> parallel_select(const E& e, thread_pool& pool = default_thread_pool()) {
+        auto bound = e.bind(*this);
+        size_t len = cur_rows > 0 ? cur_rows : 0;
+        return create_view_with_index(parallel_compact(len, [&bound](size_t first, size_t n, selection_mask::word_type* out) {
+            for (size_t i = 0; i < n; i += filter_block_rows)
+                bound.eval(first + i, std::min(filter_block_rows, n - i), out + i / selection_mask::word_bits);
+        }, pool));
+    }
+    /** @brief create a view with rows satisfying a filter expression over several columns,
+    * e.g. @code df.select(col<double>("px") > 10 && col<long>("qty") < 500) @endcode
+    * 
+    * @tparam E the filter expression type
+    * 
+    * @param e the filter expression, all referenced columns are scanned together in one pass
+    */   
+    template<typename E, typename = std::enable_if_t<is_filter_expression_v<E>>>
+    data_frame_view<Types...> select(const E& e) {
+        if (auto rows = e.bitmap(*this)) return create_view_with_index(rows->to_index());
+        return create_view_with_mask(mask(e));
+    }
+    /** @brief evaluate a filter expression into a bit-packed selection mask
+    * 
+    * @tparam E the filter expression type
+    * 
+    * @param e the filter expression
+    */   
+    template<typename E>
+    selection_mask mask(const filter_expression<E>& e) const {
+        return evaluate_filter(*this, e);
+    }
+    /** @brief number of rows satisfying a filter expression, answered from the cardinality of the bitmaps
+    * when every referenced column has a bitmap index
+    * 
+    * @tparam E the filter expression type
+    * 
+    * @param e the filter expression
+    */   
+    template<typename E>
+    size_t count(const filter_expression<E>& e) const {
+        if (auto rows = e.self().bitmap(*this)) return rows->cardinality();
+        return mask(e).count();
+    }
+    /** @brief number of rows satisfying a condition on one column
+    * 
+    * @tparam Col_type the column type to be filtered
+    * 
+    * @tparam F a built-in predicate or any functor
+    * 
+    * @param col_name the column name applying the condition
+    * 
+    * @param f the condition
+    */   
+    template<typename Col_type, typename F>
+    size_t count(const std::string& col_name, const F& f) {
+        if constexpr (is_column_predicate_v<F>) {
+            if (const auto* bitmaps = get_bitmap_index<Col_type>(col_name)) return bitmaps->lookup(f).cardinality();
+        }
+        return mask<Col_type>(col_name, f).count();
+    }
+    /** @brief evaluate a condition on one column into a bit-packed selection mask
+    * 
+    * @tparam Col_type the column type to be filtered
+    * 
+    * @tparam F a built-in predicate such as @code lt @endcode, @code between @endcode or @code in @endcode, or any functor
+    * 
+    * @param col_name the column name applying the condition
+    * 
+    * @param f the condition
+    */   
+    template<typename Col_type, typename F>
+    selection_mask mask(const std::string& col_name, const F& f);
     /** @brief create a view with new row orders after sort
     * 
     * @tparam Col_type the column type to be filtered
@@ -233,7 +554,7 @@ public:
     */   
     template<typename Col_type>
     data_frame_view<Types...> sort(const std::string& col_name) {
-        const std::vector<int>& new_order = order<Col_type>(col_name);
+        const std::vector<row_id_t>& new_order = order<Col_type>(col_name);
         return create_view_with_index(std::move(new_order));
     }
     /** @brief create a view with new row orders after sort
@@ -248,25 +569,141 @@ public:
     */   
     template<typename Col_type, typename F>
     data_frame_view<Types...> sort(const std::string& col_name, F f) {
-        const std::vector<int>& new_order = order<Col_type>(col_name, f);
+        const std::vector<row_id_t>& new_order = order<Col_type>(col_name, f);
         return create_view_with_index(std::move(new_order));
     }
+    /** @brief create a view with the first k rows of the order defined by f, like @code sort @endcode followed by
+    * @code head @endcode but without sorting every row
+    * 
+    * @tparam Col_type the column type to be ordered
+    * 
+    * @tparam F a functor for comparing two values, it's called concurrently
+    * 
+    * @param col_name the column name to be ordered
+    * 
+    * @param k number of rows to keep
+    * 
+    * @param f a functor for comparing two values
+    * 
+    * @param pool the threads to run on
+    */   
+    template<typename Col_type, typename F>
+    data_frame_view<Types...> top_k(const std::string& col_name, size_t k, F f, thread_pool& pool = default_thread_pool()) {
+        static_assert(((std::is_same_v<Col_type, Types> || ...)), "Type doesn't match to data_frame");
+        const auto* tmp_vector = get_column<Col_type>(col_name);
+        if (!tmp_vector || !tmp_vector->size()) return create_view_with_index(std::vector<row_id_t>{});
+        return create_view_with_index(parallel_top_k(&(*tmp_vector)[0], tmp_vector->size(), k, f, pool));
+    }
+    /** @brief create a view with the k rows holding the largest values of column col_name, largest first
+    * 
+    * @tparam Col_type the column type to be ordered
+    * 
+    * @param col_name the column name to be ordered
+    * 
+    * @param k number of rows to keep
+    * 
+    * @param pool the threads to run on
+    */   
+    template<typename Col_type>
+    data_frame_view<Types...> nlargest(const std::string& col_name, size_t k, thread_pool& pool = default_thread_pool()) {
+        return top_k<Col_type>(col_name, k, detail::greater_nan_last{}, pool);
+    }
+    /** @brief create a view with the k rows holding the smallest values of column col_name, smallest first
+    * 
+    * @tparam Col_type the column type to be ordered
+    * 
+    * @param col_name the column name to be ordered
+    * 
+    * @param k number of rows to keep
+    * 
+    * @param pool the threads to run on
+    */   
+    template<typename Col_type>
+    data_frame_view<Types...> nsmallest(const std::string& col_name, size_t k, thread_pool& pool = default_thread_pool()) {
+        return top_k<Col_type>(col_name, k, detail::less_nan_last{}, pool);
+    }
+    /** @brief create a view sorted by several columns, e.g. 
+    * @code df.sort_by({{"date"}, {"region"}, {"price", false}}) @endcode
+    * 
+    * @param keys the sort columns, most significant first
+    * 
+    * @param stable whether rows with equal keys keep their order
+    * 
+    * @param pool the threads to run on
+    */   
+    data_frame_view<Types...> sort_by(const std::vector<sort_key>& keys, bool stable = true, thread_pool& pool = default_thread_pool()) {
+        return create_view_with_index(order_by(keys, stable, pool));
+    }
+    /** @brief create a view without duplicate rows, e.g. @code df.drop_duplicates({"date", "sym"}, keep_duplicate::last) @endcode
+    *
+    * Rows are compared on the given columns with @code == @endcode, except that NaN equals NaN, so of several
+    * rows holding NaN in the same columns one is kept.
+    * The rows kept come in row order and don't depend on the number of threads, see @code distinct_rows @endcode.
+    * A missing column gives an empty view.
+    *
+    * @param subset the compared columns, all columns if empty
+    *
+    * @param keep which of several equal rows is kept
+    *
+    * @param pool the threads to run on
+    */
+    data_frame_view<Types...> drop_duplicates(const std::vector<std::string>& subset = {},
+        keep_duplicate keep = keep_duplicate::first, thread_pool& pool = default_thread_pool()) {
+        return create_view_with_index(unique_rows(subset, keep, pool));
+    }
+    /** @brief create a view with the first of every group of equal rows, compared on some columns
+    *
+    * @param columns the compared columns, all columns if empty
+    *
+    * @param pool the threads to run on
+    */
+    data_frame_view<Types...> distinct(const std::vector<std::string>& columns = {}, thread_pool& pool = default_thread_pool()) {
+        return drop_duplicates(columns, keep_duplicate::first, pool);
+    }
+    /** @brief the rows left after dropping duplicates on some columns, ascending
+    *
+    * @param subset the compared columns, all columns if empty
+    *
+    * @param keep which of several equal rows is kept
+    *
+    * @param pool the threads to run on
+    */
+    std::vector<row_id_t> unique_rows(const std::vector<std::string>& subset, keep_duplicate keep,
+        thread_pool& pool = default_thread_pool()) const;
+    /** @brief group the rows on the values of some columns, to aggregate every group with @code agg @endcode
+    *
+    * @code df.group_by({"sym"}).agg({sum("qty"), mean("px"), count()}) @endcode
+    *
+    * @param keys the key columns, one group of all rows if empty
+    *
+    * @param pool the threads hashing the keys
+    */
+    data_frame_group_by<Types...> group_by(const std::vector<std::string>& keys, thread_pool& pool = default_thread_pool()) const {
+        return data_frame_group_by<Types...>(this, keys, pool);
+    }
     /** @brief create a view with current data_frame
     * 
     * @param index the index number to create data_frame_view
     */   
-    data_frame_view<Types...> create_view_with_index(std::vector<int>&& index) {
+    data_frame_view<Types...> create_view_with_index(std::vector<row_id_t>&& index) {
         return data_frame_view(this, std::move(index), typename type_list<Types...>::types{});
     }
     /** @brief create a view with current data_frame
     * 
     * @param index the index number to create data_frame_view
     */   
-    data_frame_view<Types...> create_view_with_index(const std::vector<int>& index) {
+    data_frame_view<Types...> create_view_with_index(const std::vector<row_id_t>& index) {
         return data_frame_view(this, index, typename type_list<Types...>::types{});
     }
     /** @brief create a view with current data_frame
     * 
+    * @param m the selection mask to create data_frame_view
+    */   
+    data_frame_view<Types...> create_view_with_mask(const selection_mask& m) {
+        return data_frame_view(this, m.to_index(), typename type_list<Types...>::types{});
+    }
+    /** @brief create a view with current data_frame
+    * 
     * @param r the index range to create data_frame_view
     */   
     data_frame_view<Types...> create_view_with_range(const range& r) {
@@ -283,8 +720,8 @@ public:
     * 
     * @param index the index copy from current data_frame
     */   
-    data_frame<Types...> copy_with_index(const std::vector<int>& index) {
-        int len = index.size();
+    data_frame<Types...> copy_with_index(const std::vector<row_id_t>& index) {
+        row_id_t len = index.size();
         data_frame<Types...> new_df;
         for (auto iter: col_names_map) {
             const auto& col_name = iter.first;
@@ -292,7 +729,7 @@ public:
                 new_df.init_column<std::decay_t<decltype(in)>>(col_name, len);
             });
         }
-        for (int i = 0; i < len; i++) {
+        for (row_id_t i = 0; i < len; i++) {
             invoke_at(index[i], [&new_df, i](auto& in, const std::string& col_name) mutable {
                 auto iter = new_df.col_names_map.find(col_name);
                 if (iter == new_df.col_names_map.end()) return;
@@ -307,7 +744,7 @@ public:
     * @param index the range copy from current data_frame
     */   
     data_frame<Types...> copy_with_range(const range& r) {
-        int len = r.size();
+        row_id_t len = r.size();
         data_frame<Types...> new_df;
         for (auto iter: col_names_map) {
             const auto& col_name = iter.first;
@@ -315,7 +752,7 @@ public:
                 new_df.init_column<std::decay_t<decltype(in)>>(col_name, len);
             });
         }
-        for (int i = 0; i < len; i++) {
+        for (row_id_t i = 0; i < len; i++) {
             invoke_at(r(i), [&new_df, i](auto& in, const std::string& col_name) mutable {
                 auto iter = new_df.col_names_map.find(col_name);
                 if (iter == new_df.col_names_map.end()) return;
@@ -323,6 +760,12 @@ public:
                 container.data_frame_col::template at<std::decay_t<decltype(in)>>(i) = in;
             });
         }
+        // a range of a sorted column is sorted the same way
+        for (const auto& iter: col_names_map) {
+            sort_order order = get_sort_order(iter.first);
+            if (order != sort_order::none)
+                new_df.sortedness[iter.first] = {order, new_df.col_names_map.find(iter.first)->second->version};
+        }
         return new_df;
     }
     /** @brief copy a new data_frame with existing data
@@ -330,7 +773,7 @@ public:
     * @param index the slice copy from current data_frame
     */   
     data_frame<Types...> copy_with_slice(const slice& s) {
-        int len = s.size();
+        row_id_t len = s.size();
         data_frame<Types...> new_df;
         for (auto iter: col_names_map) {
             const auto& col_name = iter.first;
@@ -338,7 +781,7 @@ public:
                 new_df.init_column<std::decay_t<decltype(in)>>(col_name, len);
             });
         }
-        for (int i = 0; i < len; i++) {
+        for (row_id_t i = 0; i < len; i++) {
             invoke_at(s(i), [&new_df, i](auto& in, const std::string& col_name) mutable {
                 auto iter = new_df.col_names_map.find(col_name);
                 if (iter == new_df.col_names_map.end()) return;
@@ -357,9 +800,9 @@ public:
     * @param f the functor to compute new value
     */   
     template<typename F>
-    void apply_with_index(const std::vector<int>& index, F f) {
-        int len = index.size();
-        for (int i = 0; i < len; i++) {
+    void apply_with_index(const std::vector<row_id_t>& index, F f) {
+        row_id_t len = index.size();
+        for (row_id_t i = 0; i < len; i++) {
             apply_at(index[i], [this, functor = f](auto& in){
                 in = functor(in);
             });
@@ -369,11 +812,11 @@ public:
     * 
     * @param index the index for printing
     */   
-    void print_with_index(const std::vector<int>& index) {
-        int len = index.size();
-        for (int i = 0; i < len; i++) {
+    void print_with_index(const std::vector<row_id_t>& index) {
+        row_id_t len = index.size();
+        for (row_id_t i = 0; i < len; i++) {
             std::cout << "index " << index[i] <<": ";
-            apply_at(index[i], [this](auto& in){
+            visit_at(index[i], [](const auto& in){
                 std::cout << in << " ";
             });
             std::cout << '\n';
@@ -385,10 +828,10 @@ public:
     * @param index the range for printing
     */   
     void print_with_range(const range& index) {
-        int len = index.size();
-        for (int i = 0; i < len; i++) {
+        row_id_t len = index.size();
+        for (row_id_t i = 0; i < len; i++) {
             std::cout << "index " << index(i) <<": ";
-            apply_at(index(i), [this](auto& in){
+            visit_at(index(i), [](const auto& in){
                 std::cout << in << " ";
             });
             std::cout << '\n';
@@ -399,10 +842,10 @@ public:
     * @param index the slice for printing
     */   
     void print_with_slice(const slice& index) {
-        int len = index.size();
-        for (int i = 0; i < len; i++) {
+        row_id_t len = index.size();
+        for (row_id_t i = 0; i < len; i++) {
             std::cout << "index " << index(i) <<": ";
-            apply_at(index(i), [this](auto& in){
+            visit_at(index(i), [](const auto& in){
                 std::cout << in << " ";
             });
             std::cout << '\n';
@@ -546,7 +989,7 @@ public:
         TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr);
     /** @brief get current row number 
     */     
-    int get_cur_rows() const {
+    row_id_t get_cur_rows() const {
         return cur_rows;
     }
     /** @brief get current column number 
@@ -573,7 +1016,7 @@ public:
     * @param size row number
     */
     template<class... InnerTypes>
-    void init_columns(const std::tuple<InnerTypes...>& t, const std::vector<std::string>& names, int size) {
+    void init_columns(const std::tuple<InnerTypes...>& t, const std::vector<std::string>& names, row_id_t size) {
         for_each_in_tuple(t, [this, size](auto t, const std::string& cur_name) {
             this->init_column<decltype(t)>(cur_name, size);
         }, names);
@@ -587,9 +1030,9 @@ public:
     * @param size row number
     */
     template<typename T>
-    bool init_column(const std::string& col_name, int size);
+    bool init_column(const std::string& col_name, row_id_t size);
     template<class... InnerTypes>
-    void from_tuple(const std::tuple<InnerTypes...>& t, const std::vector<std::string>& names, int size) {
+    void from_tuple(const std::tuple<InnerTypes...>& t, const std::vector<std::string>& names, row_id_t size) {
         for_each_in_tuple(t, [this, size](auto t, std::string name){
             auto iter = this->col_names_map.find(name);
             if (iter == this->col_names_map.end()) return;
@@ -605,45 +1048,132 @@ public:
     */
     template<typename T>
     void remove_col(const std::string& col_name) {
+        std::get<zone_map_store_t<T>>(zone_maps).erase(col_name);
+        std::get<index_store_t<T>>(indexes).erase(col_name);
+        std::get<bitmap_store_t<T>>(bitmap_indexes).erase(col_name);
+        sortedness.erase(col_name);
         type_map.erase(col_name);
         auto iter = col_names_map.find(col_name);
         if (iter == col_names_map.end()) return;
         vals.erase(iter->second);
         col_names_map.erase(col_name);
     }
-    /** @brief return a new index order after sorting for column with name col_name
+    /** @brief return a new index order after sorting for column with name col_name, largest value first
+    *  
+    * The rows are sorted on a thread pool, rows with equal values keep their order. Integral and
+    * floating point columns are radix sorted, NaN values go last. String columns are radix sorted on
+    * cached 8-byte prefixes and only compared further on equal prefixes.
     *  
     * @tparam T a type for current column
     * 
     * @param col_name the column name to be sorted
+    * 
+    * @param pool the threads to run on
     */
     template<typename T>
-    std::vector<int> order(const std::string& col_name);
+    std::vector<row_id_t> order(const std::string& col_name, thread_pool& pool = default_thread_pool());
     /** @brief return a new index order after sorting for column with name col_name
     *  
+    * The rows are sorted on a thread pool, rows with equivalent values keep their order.
+    *  
     * @tparam F a user defined functor type
     * 
     * @tparam T a type for current column
     * 
     * @param col_name the column name to be sorted
     * 
-    * @param f a user defined funtor to sort on specific column
+    * @param f a user defined funtor to sort on specific column, it's called concurrently
+    * 
+    * @param pool the threads to run on
     */
     template<typename T, typename F>
-    std::vector<int> order(const std::string& col_name, F f);
+    std::vector<row_id_t> order(const std::string& col_name, F f, thread_pool& pool = default_thread_pool());
+    /** @brief return a new index order after sorting by several columns
+    *  
+    * The key columns of every row are encoded into one normalized key compared with @code memcmp @endcode,
+    * or radix sorted when it fits in 8 bytes. Arithmetic and @code std::string @endcode columns are supported,
+    * an empty order is returned for a missing or unsupported column.
+    *  
+    * @param keys the sort columns, most significant first
+    * 
+    * @param stable whether rows with equal keys keep their order
+    * 
+    * @param pool the threads to run on
+    */
+    std::vector<row_id_t> order_by(const std::vector<sort_key>& keys, bool stable = true, thread_pool& pool = default_thread_pool()) {
+        size_t len = cur_rows > 0 ? cur_rows : 0;
+        normalized_keys normalized(len);
+        for (const auto& key: keys) {
+            auto type_iter = type_map.find(key.col_name);
+            if (type_iter == type_map.end()) return {};
+            bool added = ((type_iter->second == typeid(Types).name() && add_sort_column<Types>(normalized, key)) || ...);
+            if (!added) return {};
+        }
+        return normalized.argsort(stable, pool);
+    }
 private:
+    template<class... InnerTypes, std::size_t... Is>
+    bool has_columns(const std::vector<std::string>& names, std::index_sequence<Is...>) const {
+        return ((get_column<InnerTypes>(names[Is]) != nullptr) && ...);
+    }
+    template<class... InnerTypes, std::size_t... Is>
+    void append_columns(const std::vector<std::tuple<InnerTypes...>>& t, const std::vector<std::string>& names, std::index_sequence<Is...>) {
+        (append_column<InnerTypes>(names[Is], t, [](const std::tuple<InnerTypes...>& row) -> const auto& { return std::get<Is>(row); }), ...);
+    }
+    template<typename T, typename Tuple, typename Get>
+    void append_column(const std::string& col_name, const std::vector<Tuple>& t, Get get) {
+        sort_order order = get_sort_order(col_name);
+        auto& container = *(col_names_map.find(col_name)->second);
+        auto& tmp_vector = container.data_frame_col::template get_vector<T>();
+        size_t old_rows = tmp_vector.size();
+        tmp_vector.resize(old_rows + t.size(), true);
+        for (size_t i = 0; i < t.size(); i++) tmp_vector[old_rows + i] = get(t[i]);
+        // only the new rows and the last old one are checked
+        size_t first = old_rows ? old_rows - 1 : 0;
+        if (order != sort_order::none && !is_sorted_as(&tmp_vector[first], tmp_vector.size() - first, order))
+            order = sort_order::none;
+        sortedness[col_name] = {order, container.version};
+    }
+    template<typename T>
+    bool add_sort_column(normalized_keys& normalized, const sort_key& key) const {
+        if constexpr (normalized_keys::is_supported_v<T>) {
+            const auto* tmp_vector = get_column<T>(key.col_name);
+            if (!tmp_vector) return false;
+            normalized.add_column(tmp_vector->size() ? &(*tmp_vector)[0] : nullptr, key.ascending, key.nulls);
+            return true;
+        } else {
+            return false;
+        }
+    }
     template<typename T, typename F>
-    std::vector<int> filter(const std::string& col_name, F f);
+    std::vector<row_id_t> filter(const std::string& col_name, F f);
+    template<typename T, typename F>
+    std::vector<row_id_t> parallel_filter(const std::string& col_name, const F& f, thread_pool& pool) {
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector || !tmp_vector->size()) return {};
+        const T* data = &(*tmp_vector)[0];
+        const zone_map<T>* zones = is_column_predicate_v<F> ? get_zone_map<T>(col_name) : nullptr;
+        return parallel_compact(tmp_vector->size(), [data, zones, &f](size_t first, size_t n, selection_mask::word_type* out) {
+            evaluate_predicate_with_zones(data, first, n, f, zones, out);
+        }, pool);
+    }
     template<typename F>
-    void invoke_at(int pos, F&& f) {
-        for (auto iter: col_names_map) {
+    void invoke_at(row_id_t pos, F&& f) const {
+        for (const auto& iter: col_names_map) {
             const auto& col_name = iter.first;
-            auto& container = *(iter.second);
-            container.fill_data_at(pos, col_name, std::move(f), typename type_list<Types...>::types{});
+            const auto& container = *(iter.second);
+            container.fill_data_at(pos, col_name, f, typename type_list<Types...>::types{});
         }
     }
     template<typename F>
-    void apply_at(int pos, F f) {
+    void visit_at(row_id_t pos, F f) const {
+        for (const auto& iter: col_names_map) {
+            const auto& container = *(iter.second);
+            container.apply_at(pos, f, typename type_list<Types...>::types{});
+        }
+    }
+    template<typename F>
+    void apply_at(row_id_t pos, F f) {
       for (auto iter: col_names_map) {
             const auto& col_name = iter.first;
             auto& container = *(iter.second);
@@ -651,7 +1181,7 @@ private:
         }
     }
     template<typename F>
-    void initialize(const std::string& col_name, int len, F f) {
+    void initialize(const std::string& col_name, row_id_t len, F f) {
         auto& container = col_names_map[col_name];
         container->initialize(std::move(f), typename type_list<Types...>::types{});
     }
@@ -663,21 +1193,33 @@ private:
     void for_each_in_tuple(std::tuple<Ts...> const& t, F f, const std::vector<std::string>& names) {
         for_each(t, f, std::index_sequence_for<Ts...>{}, names);
     }
-    int cur_rows;
+    template<class T>
+    using zone_map_store_t = std::unordered_map<std::string, zone_map<T>>;
+    template<class T>
+    using index_store_t = std::unordered_map<std::string, column_index<T>>;
+    template<class T>
+    using bitmap_store_t = std::unordered_map<std::string, bitmap_index<T>>;
+    row_id_t cur_rows;
     store_t vals;
     /* col_names_map and type_map should maintain consistent */
     name_map_t col_names_map;
     type_map_t type_map;
+    /* statistics derived from the columns, keyed by column name and rebuilt lazily when stale */
+    mutable boost::mp11::mp_transform<zone_map_store_t, typename type_list<Types...>::types> zone_maps;
+    mutable boost::mp11::mp_transform<index_store_t, typename type_list<Types...>::types> indexes;
+    mutable boost::mp11::mp_transform<bitmap_store_t, typename type_list<Types...>::types> bitmap_indexes;
+    /* known order of a column and the column version it was checked at */
+    std::unordered_map<std::string, std::pair<sort_order, size_t>> sortedness;
 };
 // template deduction guide
 template<template<class...> class TypeLists, class... InnerTypes>
 data_frame(TypeLists<InnerTypes...>) -> data_frame<InnerTypes...>;
 template<template<class...> class TypeLists, class... InnerTypes>
-data_frame(int rows, TypeLists<InnerTypes...>) -> data_frame<InnerTypes...>;
+data_frame(size_t rows, TypeLists<InnerTypes...>) -> data_frame<InnerTypes...>;
 
 template<class... Types>
 template<typename T>
-bool data_frame<Types...>::init_column(const std::string& col_name, int size) {
+bool data_frame<Types...>::init_column(const std::string& col_name, row_id_t size) {
     if (col_names_map.count(col_name)) return false;
     /* size check */
     if (cur_rows == -1) cur_rows = size;
@@ -699,9 +1241,13 @@ void data_frame<Types...>::from_tuples(const std::vector<std::tuple<Args...>>& t
     if (sizeof...(Args) != names.size()) return;
     cur_rows = t.size();
     init_columns(t[0], names, cur_rows);
-    for (int i = 0; i < cur_rows; i++) {
+    for (row_id_t i = 0; i < cur_rows; i++) {
         from_tuple(t[i], names, i);
     }
+    for_each_in_tuple(t[0], [this](auto v, const std::string& name) {
+        this->get_zone_map<decltype(v)>(name);
+        this->verify_sorted<decltype(v)>(name);
+    }, names);
 }
 template<class... Types>
 template<template<class...> class TypeLists, class... Args>
@@ -709,57 +1255,86 @@ void data_frame<Types...>::from_tuples(const std::vector<std::tuple<Args...>>& t
     from_tuples<Args...>(t, names);
 }
 template<class... Types>
+std::vector<row_id_t> data_frame<Types...>::unique_rows(const std::vector<std::string>& subset, keep_duplicate keep,
+    thread_pool& pool) const {
+    std::vector<std::string> names = subset;
+    if (names.empty())
+        for (const auto& col: col_names_map) names.push_back(col.first);
+    size_t len = cur_rows > 0 ? cur_rows : 0;
+    using key_type = boost::mp11::mp_rename<typename type_list<Types...>::types, composite_join_key>;
+    key_type key(len, 0);
+    for (const auto& name: names) {
+        auto add = [&](auto* tag) {
+            using T = std::remove_pointer_t<decltype(tag)>;
+            const auto* tmp_vector = get_column<T>(name);
+            if (!tmp_vector) return false;
+            key.add_column(len ? &(*tmp_vector)[0] : nullptr, static_cast<const T*>(nullptr), pool);
+            return true;
+        };
+        if (!(add(static_cast<Types*>(nullptr)) || ...)) return {};
+    }
+    return distinct_rows(key, keep, pool);
+}
+template<class... Types>
 template<typename T>
-std::vector<int> data_frame<Types...>::order(const std::string& col_name) {
-    static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
-    if (!col_names_map.count(col_name)) return {};
-    if (type_map[col_name] != typeid(T).name()) return {};
-    auto iter = col_names_map.find(col_name);
-    const auto& container = *(iter->second);
-    const auto& tmp_vector = container.data_frame_col::template get_vector<T>();
-    int len = tmp_vector.size();
-    std::vector<int> tmp_index;
-    for (int i = 0; i < tmp_vector.size(); i++) {
-        tmp_index.push_back(i);
+std::vector<row_id_t> data_frame<Types...>::order(const std::string& col_name, thread_pool& pool) {
+    if constexpr (is_radix_sortable_v<T>) {
+        static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector || !tmp_vector->size()) return {};
+        return radix_argsort(&(*tmp_vector)[0], tmp_vector->size(), true, pool);
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+        const auto* tmp_vector = get_column<T>(col_name);
+        if (!tmp_vector || !tmp_vector->size()) return {};
+        return string_argsort(&(*tmp_vector)[0], tmp_vector->size(), true, pool);
+    } else {
+        return order<T>(col_name, [](const T& l, const T& r) { return l > r; }, pool);
     }
-    auto cmp = [&](int& l, int& r) -> bool {
-        return tmp_vector[l] > tmp_vector[r];
-    };
-    std::sort(tmp_index.begin(), tmp_index.end(), cmp);
-    return tmp_index;
 }
 template<class... Types>
 template<typename T, typename F>
-std::vector<int> data_frame<Types...>::order(const std::string& col_name, F f) {
+std::vector<row_id_t> data_frame<Types...>::order(const std::string& col_name, F f, thread_pool& pool) {
+    static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+    const auto* tmp_vector = get_column<T>(col_name);
+    if (!tmp_vector || !tmp_vector->size()) return {};
+    return parallel_argsort(&(*tmp_vector)[0], tmp_vector->size(), f, pool);
+}
+template<class... Types>
+template<typename T, typename F>
+selection_mask data_frame<Types...>::mask(const std::string& col_name, const F& f) {
     static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
     if (!col_names_map.count(col_name)) return {};
     if (type_map[col_name] != typeid(T).name()) return {};
     auto iter = col_names_map.find(col_name);
-    auto& container = *(iter->second);
-    auto& tmp_vector = container.data_frame_col::template get_vector<T>();
-    int len = tmp_vector.size();
-    std::vector<int> tmp_index;
-    for (int i = 0; i < tmp_vector.size(); i++) {
-        tmp_index.push_back(i);
-    }
-    auto cmp = [&](int& l, int& r) -> bool {
-        return f(tmp_vector[l], tmp_vector[r]);
-    };
-    std::sort(tmp_index.begin(), tmp_index.end(), cmp);
-    return tmp_index;
+    const auto& container = *(iter->second);
+    const auto& tmp_vector = container.data_frame_col::template get_vector<T>();
+    size_t len = tmp_vector.size();
+    selection_mask ans(len);
+    const zone_map<T>* zones = is_column_predicate_v<F> ? get_zone_map<T>(col_name) : nullptr;
+    if (len) evaluate_predicate_with_zones(&tmp_vector.data()[0], 0, len, f, zones, ans.words());
+    return ans;
 }
 template<class... Types>
 template<typename T, typename F>
-std::vector<int> data_frame<Types...>::filter(const std::string& col_name, F f) {
+std::vector<row_id_t> data_frame<Types...>::filter(const std::string& col_name, F f) {
     static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
+    // built-in predicates are answered by an index when one fits, otherwise they are evaluated 
+    // block-wise into a mask, which is sized before expanding
+    if constexpr (is_column_predicate_v<F>) {
+        if (const auto* bitmaps = get_bitmap_index<T>(col_name)) return bitmaps->lookup(f).to_index();
+        const auto* index = get_index<T>(col_name);
+        if (index && index->supports(f)) return index->lookup(f);
+        return mask<T>(col_name, f).to_index();
+    }
     if (!col_names_map.count(col_name)) return {};
     if (type_map[col_name] != typeid(T).name()) return {};
     auto iter = col_names_map.find(col_name);
-    auto& container = *(iter->second);
-    auto& tmp_vector = container.data_frame_col::template get_vector<T>();
-    int len = tmp_vector.size();
-    std::vector<int> tmp_index;
-    for (int i = 0; i < len; i++) {
+    const auto& container = *(iter->second);
+    const auto& tmp_vector = container.data_frame_col::template get_vector<T>();
+    row_id_t len = tmp_vector.size();
+    std::vector<row_id_t> tmp_index;
+    for (row_id_t i = 0; i < len; i++) {
         if (f(tmp_vector[i]))
             tmp_index.push_back(i);
     }
@@ -780,118 +1355,252 @@ template<typename T>
 const T& data_frame<Types...>::get_c(const std::string& col_name, size_t pos) const {
     static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame");
     auto iter = col_names_map.find(col_name);
-    auto& container = *(iter->second);
-    auto& tmp_vector = container.data_frame_col::template get_vector<T>();
+    const auto& container = *(iter->second);
+    const auto& tmp_vector = container.data_frame_col::template get_vector<T>();
     return tmp_vector[pos];
 }
-template<class... Types>
-template<typename T,
-                    typename... Types2, 
-                    template<class...> class TypeLists1, typename... InnerTypes1, 
-                    template<class...> class TypeLists2, typename... InnerTypes2>
-auto data_frame<Types...>::combine_inner(const data_frame<Types2...>& other, 
-    const std::string& col_name, 
-    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
-    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = get_cur_rows();
-    int rlen = other.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = other.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-    }
+/** @brief build the data_frame of a join from its row pairs, the columns of l first
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param pairs the joined rows
+*
+* @param colnamesl the corresponding column names for each type position in InnerTypes1...
+*
+* @param colnamesr the corresponding column names for each type position in InnerTypes2...
+*
+* @param fill_left called with the value-initialized left tuple and the right row of a row without left side
+*
+* @param fill_right called with the value-initialized right tuple and the left row of a row without right side
+*/
+template<typename... Types1, typename... Types2, typename... InnerTypes1, typename... InnerTypes2,
+    typename FillLeft, typename FillRight>
+auto materialize_join(const data_frame<Types1...>& l, const data_frame<Types2...>& r, const join_pairs& pairs,
+    std::tuple<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    std::tuple<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    FillLeft fill_left, FillRight fill_right) {
     // get concated tuple type and names
     auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
     std::vector<std::string> col_names;
     for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
     for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
     std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    return *boost::numeric::ublas::make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
+    new_tuple_vec.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); i++) {
+        std::tuple<InnerTypes1...> left_tuple = {};
+        std::tuple<InnerTypes2...> right_tuple = {};
+        if (pairs.left[i] != null_row)
+            left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, pairs.left[i]);
+        else
+            fill_left(left_tuple, pairs.right[i]);
+        if (pairs.right[i] != null_row)
+            right_tuple = for_each_in_tuple(std::tuple<InnerTypes2...>{}, &r, colnamesr, pairs.right[i]);
+        else
+            fill_right(right_tuple, pairs.left[i]);
+        new_tuple_vec.push_back(std::tuple_cat(left_tuple, right_tuple));
+    }
+    return make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
 }
-template<class... Types>
-template<typename T,
-                    typename... Types2, 
-                    template<class...> class TypeLists1, typename... InnerTypes1, 
-                    template<class...> class TypeLists2, typename... InnerTypes2>
-auto data_frame<Types...>::combine_left(const data_frame<Types2...>& other, 
-    const std::string& col_name, 
-    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
-    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
+/** @brief row pairs of a join of two data frames on specific column, see @code hash_join @endcode for the order
+*
+* When both key columns are known to be sorted in the same direction, see @code get_sort_order @endcode, they are
+* merge joined. Otherwise a secondary index of either key column, see @code create_index @endcode, is probed
+* instead of building a hash table, and without one they are hash joined, on a thread pool if one is given.
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param kind which unmatched rows are kept
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*
+* @return no pairs when the key column is missing or of another type on either side
+*/
+template<typename T, typename... Types1, typename... Types2>
+join_pairs join_frame_pairs(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name, join_kind kind, thread_pool* pool = nullptr) {
+    static_assert(((std::is_same_v<T, Types1> || ...)), "T type doesn't belong to common types");
+    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
+    const auto* lcol = l.data_frame<Types1...>::template get_column<T>(col_name);
+    const auto* rcol = r.data_frame<Types2...>::template get_column<T>(col_name);
+    if (!lcol || !rcol) return {};
+    column_join_key<T> key(lcol->size() ? &(*lcol)[0] : nullptr, lcol->size(), rcol->size() ? &(*rcol)[0] : nullptr, rcol->size());
+    // two columns sorted the same way are merged, anything else is hashed
+    sort_order order = l.get_sort_order(col_name);
+    bool merge = is_less_comparable<T>::value && order != sort_order::none && order == r.get_sort_order(col_name);
+    if constexpr (is_less_comparable<T>::value) {
+        if (merge) return merge_join(key.l, key.nl, key.r, key.nr, order, kind);
+    }
+    if (const auto* index = r.data_frame<Types2...>::template get_index<T>(col_name))
+        return index_join(key.l, key.nl, key.r, key.nr, *index, true, kind);
+    if (const auto* index = l.data_frame<Types1...>::template get_index<T>(col_name))
+        return index_join(key.l, key.nl, key.r, key.nr, *index, false, kind);
+    return pool ? parallel_hash_join(key, kind, *pool) : hash_join(key, kind);
+}
+/** @brief row pairs of a join of two data frames on several columns, see @code hash_join @endcode for the order
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param kind which unmatched rows are kept
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*
+* @return no pairs when there is no key, the key lists differ in length, or a key column is missing or of
+* another type on the other side
+*/
+template<typename... Types1, typename... Types2>
+join_pairs join_frame_pairs(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, join_kind kind,
+    thread_pool* pool = nullptr) {
+    if (left_keys.empty() || left_keys.size() != right_keys.size()) return {};
+    using key_type = boost::mp11::mp_rename<typename type_list<Types1...>::types, composite_join_key>;
+    key_type key(std::max<row_id_t>(l.get_cur_rows(), 0), std::max<row_id_t>(r.get_cur_rows(), 0));
+    for (size_t k = 0; k < left_keys.size(); k++) {
+        auto add = [&](auto* tag) {
+            using T = std::remove_pointer_t<decltype(tag)>;
+            const auto* lcol = l.data_frame<Types1...>::template get_column<T>(left_keys[k]);
+            const auto* rcol = r.data_frame<Types2...>::template get_column<T>(right_keys[k]);
+            if (!lcol || !rcol) return false;
+            key.add_column(lcol->size() ? &(*lcol)[0] : nullptr, rcol->size() ? &(*rcol)[0] : nullptr);
+            return true;
+        };
+        // a dropped key column would pair rows that differ in it
+        if (!(add(static_cast<Types1*>(nullptr)) || ...)) return {};
+    }
+    return pool ? parallel_hash_join(key, kind, *pool) : hash_join(key, kind);
+}
+/** @brief join two data frames on specific column, rows are paired by @code join_frame_pairs @endcode
+*
+* The side missing from an unmatched row of an outer join is value-initialized, except its first column of
+* type T which takes the key.
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param kind which unmatched rows are kept
+*
+* @param colnamesl the corresponding column names for each type position in InnerTypes1...
+*
+* @param colnamesr the corresponding column names for each type position in InnerTypes2...
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*/
+template<typename T, typename... Types1, typename... Types2, typename... InnerTypes1, typename... InnerTypes2>
+auto join_data_frames(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name, join_kind kind,
+    std::tuple<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    std::tuple<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool* pool = nullptr) {
+    assert(sizeof...(InnerTypes1) == colnamesl.size());
     assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = get_cur_rows();
-    int rlen = other.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = other.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-    }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    for (const auto& iter: valueTopos1) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        if (!valueTopos2.count(key)) {
-            std::tuple<InnerTypes2...> right_tuple = {};
-            std::get<T>(right_tuple) = key;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    return *boost::numeric::ublas::make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
+    join_pairs pairs = join_frame_pairs<T>(l, r, col_name, kind, pool);
+    // without the key column on both sides there are no pairs, and no unmatched row to fill
+    const auto* lcol = l.data_frame<Types1...>::template get_column<T>(col_name);
+    const auto* rcol = r.data_frame<Types2...>::template get_column<T>(col_name);
+    return materialize_join(l, r, pairs, std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr,
+        [rcol](std::tuple<InnerTypes1...>& t, row_id_t row) { std::get<T>(t) = (*rcol)[row]; },
+        [lcol](std::tuple<InnerTypes2...>& t, row_id_t row) { std::get<T>(t) = (*lcol)[row]; });
+}
+// the column of the other side a join key column takes its value from, nullptr for other columns
+template<typename T, typename... Types>
+const typename data_frame_col::store_type<T>* join_key_source(const data_frame<Types...>& other, const std::string& name,
+    const std::vector<std::string>& keys, const std::vector<std::string>& other_keys) {
+    for (size_t k = 0; k < keys.size(); k++)
+        if (keys[k] == name) return other.data_frame<Types...>::template get_column<T>(other_keys[k]);
+    return nullptr;
+}
+template<typename... Ts, typename... Types, std::size_t... Is>
+auto join_key_sources(std::tuple<Ts...>, const std::vector<std::string>& names, const std::vector<std::string>& keys,
+    const data_frame<Types...>& other, const std::vector<std::string>& other_keys, std::index_sequence<Is...>) {
+    return std::make_tuple(join_key_source<Ts>(other, names[Is], keys, other_keys)...);
+}
+template<typename... Ts, typename... Ss, std::size_t... Is>
+void fill_join_keys(std::tuple<Ts...>& t, const std::tuple<Ss...>& sources, row_id_t row, std::index_sequence<Is...>) {
+    ((std::get<Is>(sources) ? (void)(std::get<Is>(t) = (*std::get<Is>(sources))[row]) : void()), ...);
+}
+/** @brief join two data frames on several columns, see @code hash_join @endcode for the row order
+*
+* The key is hashed and compared column by column, see @code composite_join_key @endcode. The side missing
+* from an unmatched row of an outer join is value-initialized, except its key columns which take the key.
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param kind which unmatched rows are kept
+*
+* @param colnamesl the corresponding column names for each type position in InnerTypes1...
+*
+* @param colnamesr the corresponding column names for each type position in InnerTypes2...
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*/
+template<typename... Types1, typename... Types2, typename... InnerTypes1, typename... InnerTypes2>
+auto join_data_frames(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys, join_kind kind,
+    std::tuple<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    std::tuple<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool* pool = nullptr) {
+    assert(sizeof...(InnerTypes1) == colnamesl.size());
+    assert(sizeof...(InnerTypes2) == colnamesr.size());
+    join_pairs pairs = join_frame_pairs(l, r, left_keys, right_keys, kind, pool);
+    auto left_sources = join_key_sources(std::tuple<InnerTypes1...>{}, colnamesl, left_keys, r, right_keys,
+        std::index_sequence_for<InnerTypes1...>{});
+    auto right_sources = join_key_sources(std::tuple<InnerTypes2...>{}, colnamesr, right_keys, l, left_keys,
+        std::index_sequence_for<InnerTypes2...>{});
+    return materialize_join(l, r, pairs, std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr,
+        [&left_sources](std::tuple<InnerTypes1...>& t, row_id_t row) {
+            fill_join_keys(t, left_sources, row, std::index_sequence_for<InnerTypes1...>{});
+        },
+        [&right_sources](std::tuple<InnerTypes2...>& t, row_id_t row) {
+            fill_join_keys(t, right_sources, row, std::index_sequence_for<InnerTypes2...>{});
+        });
+}
+template<class... Types>
+template<typename T,
+                    typename... Types2, 
+                    template<class...> class TypeLists1, typename... InnerTypes1, 
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto data_frame<Types...>::combine_inner(const data_frame<Types2...>& other, 
+    const std::string& col_name, 
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return *join_data_frames<T>(*this, other, col_name, join_kind::inner,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
+}
+template<class... Types>
+template<typename T,
+                    typename... Types2, 
+                    template<class...> class TypeLists1, typename... InnerTypes1, 
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto data_frame<Types...>::combine_left(const data_frame<Types2...>& other, 
+    const std::string& col_name, 
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return *join_data_frames<T>(*this, other, col_name, join_kind::left,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
 }
 template<class... Types>
 template<typename T,
@@ -902,59 +1611,8 @@ auto data_frame<Types...>::combine_right(const data_frame<Types2...>& other,
     const std::string& col_name, 
     TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
     TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = get_cur_rows();
-    int rlen = other.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    std::multimap<T, size_t> valsNotInLeft;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = other.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-        else {
-            valsNotInLeft.insert({val, j});
-        }
-    }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    // adding remaining right rows which doesn't include in the left `data_frame`
-    for (const auto& iter: valsNotInLeft) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes1...> left_tuple = {};
-        std::get<T>(left_tuple) = key;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-        new_tuple_vec.push_back(combined_tuple);
-    }
-    return *boost::numeric::ublas::make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
+    return *join_data_frames<T>(*this, other, col_name, join_kind::right,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
 }
 template<class... Types>
 template<typename T,
@@ -965,81 +1623,18 @@ auto data_frame<Types...>::combine_full(const data_frame<Types2...>& other,
     const std::string& col_name, 
     TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
     TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = get_cur_rows();
-    int rlen = other.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    std::multimap<T, size_t> valsNotInLeft;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = other.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-        else {
-            valsNotInLeft.insert({val, j});
-        }
-    }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    // adding remaining left rows which doesn't include in the right `data_frame`
-    for (const auto& iter: valueTopos1) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        if (!valueTopos2.count(key)) {
-            std::tuple<InnerTypes2...> right_tuple = {};
-            std::get<T>(right_tuple) = key;
-            std::tuple<InnerTypes1...> left_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes1...>{}, this, colnamesl, pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    // adding remaining right rows which doesn't include in the left `data_frame`
-    for (const auto& iter: valsNotInLeft) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes1...> left_tuple = {};
-        std::get<T>(left_tuple) = key;
-        std::tuple<InnerTypes2...> right_tuple = boost::numeric::ublas::for_each_in_tuple(std::tuple<InnerTypes2...>{}, &other, colnamesr, pos);
-        auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-        new_tuple_vec.push_back(combined_tuple);
-    }
-    return *boost::numeric::ublas::make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
+    return *join_data_frames<T>(*this, other, col_name, join_kind::full,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
 }
 // A non-deduced context from tuple inside vector to make_from_tuples, have to provide additional parameter
 template<template<class...> class TypeLists, class... InnerTypes>
 auto make_from_tuples(const std::vector<TypeLists<InnerTypes...>>& t, const std::vector<std::string>& names) {
     using type_collection = typename type_list<InnerTypes...>::types;
     assert(sizeof...(InnerTypes) == names.size());
-    int cur_rows = t.size();
+    row_id_t cur_rows = t.size();
     auto df = new data_frame(cur_rows, type_collection{});
-    df->init_columns(t[0], names, cur_rows);
-    for (int i = 0; i < cur_rows; i++)
+    df->init_columns(t.empty() ? std::tuple<InnerTypes...>{} : t[0], names, cur_rows);
+    for (row_id_t i = 0; i < cur_rows; i++)
         df->from_tuple(t[i], names, i);
     return df;
 }
@@ -1082,46 +1677,8 @@ auto combine_inner(const data_frame<Types1...>& l, const data_frame<Types2...>&
     const std::string& col_name, 
     TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
     TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types1> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types1...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({l.data_frame<Types1...>::template get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = r.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-    }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes2...>{}, &r, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    auto new_df = make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
-    return new_df;
+    return join_data_frames<T>(l, r, col_name, join_kind::inner,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
 }
 /** @brief left join two data frames on specific column 
 * 
@@ -1162,58 +1719,8 @@ auto combine_left(const data_frame<Types1...>& l, const data_frame<Types2...>& r
     const std::string& col_name, 
     TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
     TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types1> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types1...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({l.data_frame<Types1...>::template get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = r.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-    }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes2...>{}, &r, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    // adding remaining left rows which doesn't include in the right `data_frame`
-    for (const auto& iter: valueTopos1) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        if (!valueTopos2.count(key)) {
-            std::tuple<InnerTypes2...> right_tuple = {};
-            std::get<T>(right_tuple) = key;
-            std::tuple<InnerTypes1...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
-        }
-    }
-    auto new_df = make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
-    return new_df;
+    return join_data_frames<T>(l, r, col_name, join_kind::left,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
 }
 /** @brief right join two data frames on specific column 
 * 
@@ -1295,74 +1802,414 @@ auto combine_full(const data_frame<Types1...>& l, const data_frame<Types2...>& r
     const std::string& col_name, 
     TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl, 
     TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
-    static_assert(((std::is_same_v<T, Types1> || ...)), "T type doesn't belong to common types");
-    static_assert(((std::is_same_v<T, Types2> || ...)), "T type doesn't belong to common types");
-    assert(sizeof...(InnerTypes1) == colnamesl.size());
-    assert(sizeof...(InnerTypes2) == colnamesr.size());
-    using type_collection_l = typename type_list<Types1...>::types;
-    using type_collection_r = typename type_list<Types2...>::types;
-    auto merge_type_collection = merge_types(type_collection_l{}, type_collection_r{});
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    std::multimap<T, size_t> valueTopos1;
-    std::multimap<T, size_t> valueTopos2;
-    std::multimap<T, size_t> valsNotInLeft;
-    // Must iterate twice to get the number of rows in result data frame
-    for (int i = 0; i < llen; i++)
-        valueTopos1.insert({l.data_frame<Types1...>::template get_c<T>(col_name, i), i});
-    for (int j = 0; j < rlen; j++) {
-        const T& val = r.data_frame<Types2...>::template get_c<T>(col_name, j);
-        if (valueTopos1.count(val))
-            valueTopos2.insert({val, j});
-        else {
-            valsNotInLeft.insert({val, j});
+    return join_data_frames<T>(l, r, col_name, join_kind::full,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
+}
+/** @brief inner join two data frames on specific column like @code combine_inner @endcode, hash joining
+* with @code parallel_hash_join @endcode on a thread pool
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*
+* @param pool the threads to join on
+*/
+template<typename T,
+                    typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto parallel_combine_inner(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool& pool = default_thread_pool()) {
+    return join_data_frames<T>(l, r, col_name, join_kind::inner,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr, &pool);
+}
+/** @brief left join two data frames on specific column like @code combine_left @endcode, hash joining
+* with @code parallel_hash_join @endcode on a thread pool
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*
+* @param pool the threads to join on
+*/
+template<typename T,
+                    typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto parallel_combine_left(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool& pool = default_thread_pool()) {
+    return join_data_frames<T>(l, r, col_name, join_kind::left,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr, &pool);
+}
+/** @brief right join two data frames on specific column like @code combine_right @endcode, hash joining
+* with @code parallel_hash_join @endcode on a thread pool
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*
+* @param pool the threads to join on
+*/
+template<typename T,
+                    typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto parallel_combine_right(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool& pool = default_thread_pool()) {
+    return parallel_combine_left<T>(r, l, col_name, TypeLists2<InnerTypes2...>{}, colnamesr, TypeLists1<InnerTypes1...>{}, colnamesl, pool);
+}
+/** @brief full join two data frames on specific column like @code combine_full @endcode, hash joining
+* with @code parallel_hash_join @endcode on a thread pool
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*
+* @param pool the threads to join on
+*/
+template<typename T,
+                    typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto parallel_combine_full(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr,
+    thread_pool& pool = default_thread_pool()) {
+    return join_data_frames<T>(l, r, col_name, join_kind::full,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr, &pool);
+}
+/** @brief inner join two data frames on several key columns, see @code composite_join_key @endcode
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*/
+template<typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto combine_inner(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return join_data_frames(l, r, left_keys, right_keys, join_kind::inner,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
+}
+/** @brief left join two data frames on several key columns, see @code composite_join_key @endcode
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*/
+template<typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto combine_left(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return join_data_frames(l, r, left_keys, right_keys, join_kind::left,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
+}
+/** @brief right join two data frames on several key columns, see @code composite_join_key @endcode
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*/
+template<typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto combine_right(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return combine_left(r, l, right_keys, left_keys, TypeLists2<InnerTypes2...>{}, colnamesr, TypeLists1<InnerTypes1...>{}, colnamesl);
+}
+/** @brief full join two data frames on several key columns, see @code composite_join_key @endcode
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param TypeLists1<InnerTypes1...> used to deduct tuple type for current data_frame
+*
+* @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+*
+* @param TypeLists2<InnerTypes2...> used to deduct tuple type for second data_frame
+*
+* @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+*/
+template<typename... Types1,
+                    typename... Types2,
+                    template<class...> class TypeLists1, typename... InnerTypes1,
+                    template<class...> class TypeLists2, typename... InnerTypes2>
+auto combine_full(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys,
+    TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+    TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr) {
+    return join_data_frames(l, r, left_keys, right_keys, join_kind::full,
+        std::tuple<InnerTypes1...>{}, colnamesl, std::tuple<InnerTypes2...>{}, colnamesr);
+}
+/* the compared columns of one data_frame, rows are compared on them lexicographically; valid is false when a
+ * column is missing or of none of Types */
+template<typename... Types>
+struct row_columns {
+    template<typename... FrameTypes>
+    row_columns(const data_frame<FrameTypes...>& df, const std::vector<std::string>& names) {
+        for (const auto& name: names) {
+            auto add = [&](auto* tag) {
+                using T = std::remove_pointer_t<decltype(tag)>;
+                const auto* vec = df.data_frame<FrameTypes...>::template get_column<T>(name);
+                if (!vec) return false;
+                cols.emplace_back(std::in_place_type<const T*>, vec->size() ? &(*vec)[0] : nullptr);
+                return true;
+            };
+            valid = valid && (add(static_cast<Types*>(nullptr)) || ...);
         }
     }
-    // get concated tuple type and names
-    auto tuple_cat_val = std::tuple_cat(std::tuple<InnerTypes1...>{}, std::tuple<InnerTypes2...>{});
-    std::vector<std::string> col_names;
-    for (const auto& l_name: colnamesl) { col_names.push_back(l_name); }
-    for (const auto& r_name: colnamesr) { col_names.push_back(r_name); }
-    // need to iterate through valueTopos2 to get common data
-    std::vector<decltype(tuple_cat_val)> new_tuple_vec;
-    for (const auto& iter: valueTopos2) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes2...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes2...>{}, &r, colnamesr, pos);
-        auto tmp_range = valueTopos1.equal_range(key);
-        for (auto i = tmp_range.first; i != tmp_range.second; ++i) {
-            size_t l_pos = i->second;
-            std::tuple<InnerTypes1...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, l_pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
+    std::vector<std::variant<const Types*...>> cols;
+    bool valid = true;
+};
+/* three-way comparison of row i of a with row j of b, both with the same column types */
+template<typename... Types>
+int compare_rows(const row_columns<Types...>& a, size_t i, const row_columns<Types...>& b, size_t j) {
+    for (size_t k = 0; k < a.cols.size(); k++) {
+        int c = std::visit([&](auto pa) {
+            auto pb = std::get<decltype(pa)>(b.cols[k]);
+            return pa[i] < pb[j] ? -1 : (pb[j] < pa[i] ? 1 : 0);
+        }, a.cols[k]);
+        if (c) return c;
+    }
+    return 0;
+}
+/* whether n rows follow order lexicographically, NaN makes a column unordered */
+template<typename... Types>
+bool rows_sorted(const row_columns<Types...>& c, size_t n, sort_order order) {
+    for (const auto& col: c.cols) {
+        bool ordered = std::visit([n](auto p) {
+            using T = std::remove_const_t<std::remove_pointer_t<decltype(p)>>;
+            if constexpr (std::is_floating_point_v<T>) {
+                for (size_t i = 0; i < n; i++)
+                    if (std::isnan(p[i])) return false;
+            }
+            return true;
+        }, col);
+        if (!ordered) return false;
+    }
+    int dir = order == sort_order::descending ? -1 : 1;
+    for (size_t i = 1; i < n; i++)
+        if (dir * compare_rows(c, i - 1, c, i) > 0) return false;
+    return true;
+}
+/** @brief kinds of set operation over the rows of two data_frames
+ */
+enum class set_operation { intersect, difference, union_ };
+/* set_operation_rows over two inputs sorted the same way, as one merge pass */
+template<typename... Types>
+std::pair<std::vector<row_id_t>, std::vector<row_id_t>> merge_set_operation_rows(const row_columns<Types...>& l, size_t nl,
+    const row_columns<Types...>& r, size_t nr, sort_order order, set_operation op) {
+    int dir = order == sort_order::descending ? -1 : 1;
+    std::pair<std::vector<row_id_t>, std::vector<row_id_t>> ans;
+    size_t i = 0, j = 0;
+    auto skip = [](const row_columns<Types...>& c, size_t n, size_t& pos) {
+        for (++pos; pos < n && compare_rows(c, pos - 1, c, pos) == 0; ++pos) {}
+    };
+    while (i < nl || j < nr) {
+        if (op == set_operation::intersect && (i == nl || j == nr)) break;
+        int c = i == nl ? 1 : (j == nr ? -1 : dir * compare_rows(l, i, r, j));
+        if (c < 0) {
+            if (op != set_operation::intersect) ans.first.push_back(static_cast<row_id_t>(i));
+            skip(l, nl, i);
+        } else if (c > 0) {
+            if (op != set_operation::intersect) ans.second.push_back(static_cast<row_id_t>(j));
+            skip(r, nr, j);
+        } else {
+            if (op != set_operation::difference) ans.first.push_back(static_cast<row_id_t>(i));
+            skip(l, nl, i);
+            skip(r, nr, j);
         }
     }
-    // adding remaining left rows which doesn't include in the right `data_frame`
-    for (const auto& iter: valueTopos1) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        if (!valueTopos2.count(key)) {
-            std::tuple<InnerTypes2...> right_tuple = {};
-            std::get<T>(right_tuple) = key;
-            std::tuple<InnerTypes1...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes1...>{}, &l, colnamesl, pos);
-            auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-            new_tuple_vec.push_back(combined_tuple);
+    return ans;
+}
+/* the rows of l and r taking part in a set operation, each distinct row once in first-seen order: rows of l
+ * before rows of r, nothing when a column is missing or of another type. Rows are hashed column by column
+ * and compared on the columns themselves, NaN equal to NaN, or merged when both frames are known to be sorted
+ * the same way on the columns. */
+template<typename... Types, typename... InnerTypes, std::size_t... Is>
+std::optional<std::pair<std::vector<row_id_t>, std::vector<row_id_t>>> set_operation_rows(const data_frame<Types...>& l,
+    const data_frame<Types...>& r, std::tuple<InnerTypes...>, const std::vector<std::string>& colnames,
+    set_operation op, std::index_sequence<Is...>) {
+    assert(sizeof...(InnerTypes) == colnames.size());
+    size_t nl = std::max<row_id_t>(l.get_cur_rows(), 0), nr = std::max<row_id_t>(r.get_cur_rows(), 0);
+    // inputs sorted the same way on the compared columns are merged, the result is the same
+    if constexpr ((is_less_comparable<InnerTypes>::value && ...)) {
+        sort_order order = colnames.empty() ? sort_order::none : l.get_sort_order(colnames[0]);
+        if (order != sort_order::none && order == r.get_sort_order(colnames[0])) {
+            using columns_type = boost::mp11::mp_rename<typename type_list<InnerTypes...>::types, row_columns>;
+            columns_type lc(l, colnames), rc(r, colnames);
+            bool sorted = colnames.size() == 1 || (rows_sorted(lc, nl, order) && rows_sorted(rc, nr, order));
+            if (lc.valid && rc.valid && sorted) return merge_set_operation_rows(lc, nl, rc, nr, order, op);
         }
     }
-    // adding remaining right rows which doesn't include in the left `data_frame`
-    for (const auto& iter: valsNotInLeft) {
-        T key = iter.first;
-        size_t pos = iter.second;
-        std::tuple<InnerTypes1...> left_tuple = {};
-        std::get<T>(left_tuple) = key;
-        std::tuple<InnerTypes2...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes2...>{}, &r, colnamesr, pos);
-        auto combined_tuple = std::tuple_cat(left_tuple, right_tuple);
-        new_tuple_vec.push_back(combined_tuple);
-    }
-    auto new_df = make_from_tuples(new_tuple_vec, col_names, tuple_cat_val);
-    return new_df;
+    using key_type = boost::mp11::mp_rename<typename type_list<InnerTypes...>::types, composite_join_key>;
+    key_type key(nl, nr);
+    auto add = [&key, nl, nr](const auto* lcol, const auto* rcol) {
+        if (!lcol || !rcol) return false;
+        key.add_column(nl ? &(*lcol)[0] : nullptr, nr ? &(*rcol)[0] : nullptr);
+        return true;
+    };
+    if (!(add(l.data_frame<Types...>::template get_column<InnerTypes>(colnames[Is]),
+              r.data_frame<Types...>::template get_column<InnerTypes>(colnames[Is])) && ...)) return std::nullopt;
+    std::vector<std::uint64_t> lh(nl), rh(nr);
+    for (size_t i = 0; i < nl; i++) lh[i] = key.hash_left(static_cast<row_id_t>(i));
+    for (size_t j = 0; j < nr; j++) rh[j] = key.hash_right(static_cast<row_id_t>(j));
+    join_hash_table ltable, rtable;
+    ltable.build(nl, lh.data(), [&key](row_id_t a, row_id_t b) { return key.same_left(a, b); });
+    rtable.build(nr, rh.data(), [&key](row_id_t a, row_id_t b) { return key.same_right(a, b); });
+    // groups are numbered in first-seen order and start with their first row
+    std::pair<std::vector<row_id_t>, std::vector<row_id_t>> ans;
+    for (size_t g = 0; g < ltable.groups(); g++) {
+        row_id_t row = *ltable.group_rows(static_cast<row_id_t>(g)).first;
+        bool in_r = rtable.find(lh[row], [&key, row](row_id_t j) { return key.same(row, j); }) != null_row;
+        if (op == set_operation::union_ || in_r == (op == set_operation::intersect)) ans.first.push_back(row);
+    }
+    if (op == set_operation::intersect) return ans;
+    for (size_t g = 0; g < rtable.groups(); g++) {
+        row_id_t row = *rtable.group_rows(static_cast<row_id_t>(g)).first;
+        if (ltable.find(rh[row], [&key, row](row_id_t i) { return key.same(i, row); }) == null_row) ans.second.push_back(row);
+    }
+    return ans;
+}
+/* a new data_frame of rows of l followed by rows of r, gathered column at a time, nullptr without rows */
+template<typename... Types, typename... InnerTypes, std::size_t... Is>
+auto gather_rows(const data_frame<Types...>& l, const data_frame<Types...>& r,
+    const std::optional<std::pair<std::vector<row_id_t>, std::vector<row_id_t>>>& rows,
+    std::tuple<InnerTypes...>, const std::vector<std::string>& colnames, std::index_sequence<Is...>) {
+    using type_collection = typename type_list<InnerTypes...>::types;
+    if (!rows) return static_cast<decltype(new data_frame(size_t(0), type_collection{}))>(nullptr);
+    const auto& lrows = rows->first;
+    const auto& rrows = rows->second;
+    auto df = new data_frame(lrows.size() + rrows.size(), type_collection{});
+    std::set<std::string> taken;
+    auto gather = [&](const auto* lcol, const auto* rcol, const std::string& name) {
+        if (!taken.insert(name).second) return;
+        std::vector<std::decay_t<decltype((*lcol)[0])>> values;
+        values.reserve(lrows.size() + rrows.size());
+        for (row_id_t row: lrows) values.push_back((*lcol)[row]);
+        for (row_id_t row: rrows) values.push_back((*rcol)[row]);
+        df->add_column(name, std::move(values));
+    };
+    (gather(l.data_frame<Types...>::template get_column<InnerTypes>(colnames[Is]),
+            r.data_frame<Types...>::template get_column<InnerTypes>(colnames[Is]), colnames[Is]), ...);
+    return df;
 }
-/** @brief row intersect of two data_frames with the same type
+/** @brief row intersect of two data_frames with the same type, the distinct rows of l found in r in first-seen
+* order
 *
 * @tparam Types... the template argument for data_frames
 * 
@@ -1377,33 +2224,18 @@ auto combine_full(const data_frame<Types1...>& l, const data_frame<Types2...>& r
 * @param TypeLists<InnerTypes...> used to deduct tuple type for current data_frame
 * 
 * @param colnames the corresponding column names for each type position in TypeLists<InnerTypes...>
+*
+* @return nullptr when a column is missing or of another type on either side
 */  
 template<typename... Types, template<class...> class TypeLists, typename... InnerTypes>
 auto intersect(const data_frame<Types...>& l, const data_frame<Types...>& r, 
     TypeLists<InnerTypes...>, const std::vector<std::string>& colnames) {
-    std::vector<std::string> col_names;
-    for (const auto& name: colnames) col_names.push_back(name);
-    std::set<std::tuple<InnerTypes...>> left_tuples_set;
-    std::set<std::tuple<InnerTypes...>> right_tuples_set;
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    for (int i = 0; i < llen; i++) {
-        std::tuple<InnerTypes...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &l, colnames, i);
-        left_tuples_set.insert(left_tuple);
-    }
-    for (int i = 0; i < rlen; i++) {
-        std::tuple<InnerTypes...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &r, colnames, i);
-        right_tuples_set.insert(right_tuple);       
-    }
-    std::vector<std::tuple<InnerTypes...>> interset_tuples;
-    for (const auto& iter: left_tuples_set) {
-        if (right_tuples_set.count(iter)) {
-            interset_tuples.push_back(iter);
-        }
-    }
-    return make_from_tuples(interset_tuples, col_names, TypeLists<InnerTypes...>{});
+    auto rows = set_operation_rows(l, r, std::tuple<InnerTypes...>{}, colnames, set_operation::intersect,
+        std::index_sequence_for<InnerTypes...>{});
+    return gather_rows(l, r, rows, std::tuple<InnerTypes...>{}, colnames, std::index_sequence_for<InnerTypes...>{});
 }
-/** @brief the tuples containing in l data_frame but don't exist in r data_frame
+/** @brief the tuples containing in l data_frame but don't exist in r data_frame, and the other way round,
+* each distinct row once in first-seen order, those of l first
 *
 * @tparam Types... the template argument for data_frames
 * 
@@ -1418,38 +2250,18 @@ auto intersect(const data_frame<Types...>& l, const data_frame<Types...>& r,
 * @param TypeLists<InnerTypes...> used to deduct tuple type for current data_frame
 * 
 * @param colnames the corresponding column names for each type position in TypeLists<InnerTypes...>
+*
+* @return nullptr when a column is missing or of another type on either side
 */  
 template<typename... Types, template<class...> class TypeLists, typename... InnerTypes>
 auto setdiff(const data_frame<Types...>& l, const data_frame<Types...>& r, 
     TypeLists<InnerTypes...>, const std::vector<std::string>& colnames) {
-    std::vector<std::string> col_names;
-    for (const auto& name: colnames) col_names.push_back(name);
-    std::set<std::tuple<InnerTypes...>> left_tuples_set;
-    std::set<std::tuple<InnerTypes...>> right_tuples_set;
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    for (int i = 0; i < llen; i++) {
-        std::tuple<InnerTypes...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &l, colnames, i);
-        left_tuples_set.insert(left_tuple);
-    }
-    for (int i = 0; i < rlen; i++) {
-        std::tuple<InnerTypes...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &r, colnames, i);
-        right_tuples_set.insert(right_tuple);       
-    }
-    std::vector<std::tuple<InnerTypes...>> interset_tuples;
-    for (const auto& iter: left_tuples_set) {
-        if (!right_tuples_set.count(iter)) {
-            interset_tuples.push_back(iter);
-        }
-    }
-    for (const auto& iter: right_tuples_set) {
-        if (!left_tuples_set.count(iter)) {
-            interset_tuples.push_back(iter);
-        }
-    }
-    return make_from_tuples(interset_tuples, col_names, TypeLists<InnerTypes...>{});
+    auto rows = set_operation_rows(l, r, std::tuple<InnerTypes...>{}, colnames, set_operation::difference,
+        std::index_sequence_for<InnerTypes...>{});
+    return gather_rows(l, r, rows, std::tuple<InnerTypes...>{}, colnames, std::index_sequence_for<InnerTypes...>{});
 }
-/** @brief the tuples containing in l data_frame or exist in r data_frame
+/** @brief the tuples containing in l data_frame or exist in r data_frame, each distinct row once in first-seen
+* order, those of l first
 *
 * @tparam Types... the template argument for data_frames
 * 
@@ -1464,29 +2276,108 @@ auto setdiff(const data_frame<Types...>& l, const data_frame<Types...>& r,
 * @param TypeLists<InnerTypes...> used to deduct tuple type for current data_frame
 * 
 * @param colnames the corresponding column names for each type position in TypeLists<InnerTypes...>
+*
+* @return nullptr when a column is missing or of another type on either side
 */  
 template<typename... Types, template<class...> class TypeLists, typename... InnerTypes>
-auto setunion(const data_frame<Types...>& l, const data_frame<Types...>& r, 
+auto setunion(const data_frame<Types...>& l, const data_frame<Types...>& r,
     TypeLists<InnerTypes...>, const std::vector<std::string>& colnames) {
-    std::vector<std::string> col_names;
-    for (const auto& name: colnames) col_names.push_back(name);
-    std::set<std::tuple<InnerTypes...>> left_tuples_set;
-    std::set<std::tuple<InnerTypes...>> right_tuples_set;
-    std::set<std::tuple<InnerTypes...>> complete_tuples_set;
-    int llen = l.get_cur_rows();
-    int rlen = r.get_cur_rows();
-    for (int i = 0; i < llen; i++) {
-        std::tuple<InnerTypes...> left_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &l, colnames, i);
-        left_tuples_set.insert(left_tuple);
-        complete_tuples_set.insert(left_tuple);
-    }
-    for (int i = 0; i < rlen; i++) {
-        std::tuple<InnerTypes...> right_tuple = for_each_in_tuple(std::tuple<InnerTypes...>{}, &r, colnames, i);
-        right_tuples_set.insert(right_tuple);      
-        complete_tuples_set.insert(right_tuple); 
-    }
-    std::vector<std::tuple<InnerTypes...>> interset_tuples(complete_tuples_set.begin(), complete_tuples_set.end());
-    return make_from_tuples(interset_tuples, col_names, TypeLists<InnerTypes...>{});
+    auto rows = set_operation_rows(l, r, std::tuple<InnerTypes...>{}, colnames, set_operation::union_,
+        std::index_sequence_for<InnerTypes...>{});
+    return gather_rows(l, r, rows, std::tuple<InnerTypes...>{}, colnames, std::index_sequence_for<InnerTypes...>{});
+}
+/** @brief set operation over two streams of data_frame chunks sorted the same way on colnames, holding at most
+* two chunks per side in memory
+*
+* Each distinct row is output once, in key order, from the side it was first seen on (l for rows of both).
+* The inputs must not hold NaN in the compared columns.
+*
+* @tparam Types... the template argument for the chunks
+*
+* @param op the set operation, difference is the symmetric one like @code setdiff @endcode
+*
+* @param colnames the compared columns, every chunk must have them with the same types on both sides
+*
+* @param next_left functor filling an empty @code data_frame<Types...>& @endcode with the next chunk of l,
+* false at the end
+*
+* @param next_right the same for r
+*
+* @param sink called with (const data_frame<Types...>& chunk, row_id_t row, bool from_left) for every row output
+*
+* @param order the order both inputs are sorted in
+*
+* @return false when a chunk lacks one of colnames or their types differ
+*/
+template<typename... Types, typename Left, typename Right, typename Sink>
+bool merge_set_operation(set_operation op, const std::vector<std::string>& colnames, Left next_left,
+    Right next_right, Sink sink, sort_order order = sort_order::ascending) {
+    using frame_type = data_frame<Types...>;
+    using columns_type = boost::mp11::mp_rename<typename type_list<Types...>::types, row_columns>;
+    std::vector<size_t> kinds;
+    // the current chunk of one side and the one before it, to skip equal rows across the boundary
+    struct cursor {
+        bool load(std::function<bool(frame_type&)>& next, const std::vector<std::string>& names,
+            std::vector<size_t>& kinds) {
+            prev = std::move(cur);
+            prev_cols = std::move(cols);
+            prev_rows = rows;
+            cols.reset();
+            while (true) {
+                auto chunk = std::make_unique<frame_type>();
+                if (!next(*chunk)) return false;
+                rows = std::max<row_id_t>(chunk->get_cur_rows(), 0);
+                if (!rows) continue;
+                cur = std::move(chunk);
+                cols.emplace(*cur, names);
+                pos = 0;
+                std::vector<size_t> chunk_kinds;
+                for (const auto& col: cols->cols) chunk_kinds.push_back(col.index());
+                if (kinds.empty()) kinds = chunk_kinds;
+                valid = cols->valid && kinds == chunk_kinds;
+                if (!valid) cur.reset();
+                return valid;
+            }
+        }
+        // move past the current row and the rows equal to it
+        void skip(std::function<bool(frame_type&)>& next, const std::vector<std::string>& names,
+            std::vector<size_t>& kinds) {
+            for (++pos; ; ++pos) {
+                if (pos == rows) {
+                    if (!load(next, names, kinds)) return;
+                    if (compare_rows(*prev_cols, prev_rows - 1, *cols, 0)) return;
+                } else if (compare_rows(*cols, pos - 1, *cols, pos)) {
+                    return;
+                }
+            }
+        }
+        bool done() const { return !cur; }
+        std::unique_ptr<frame_type> cur, prev;
+        std::optional<columns_type> cols, prev_cols;
+        size_t pos = 0, rows = 0, prev_rows = 0;
+        bool valid = true;
+    };
+    std::function<bool(frame_type&)> next_l = std::move(next_left), next_r = std::move(next_right);
+    cursor l, r;
+    l.load(next_l, colnames, kinds);
+    r.load(next_r, colnames, kinds);
+    int dir = order == sort_order::descending ? -1 : 1;
+    while (l.valid && r.valid && (!l.done() || !r.done())) {
+        if (op == set_operation::intersect && (l.done() || r.done())) break;
+        int c = l.done() ? 1 : (r.done() ? -1 : dir * compare_rows(*l.cols, l.pos, *r.cols, r.pos));
+        if (c < 0) {
+            if (op != set_operation::intersect) sink(std::as_const(*l.cur), static_cast<row_id_t>(l.pos), true);
+            l.skip(next_l, colnames, kinds);
+        } else if (c > 0) {
+            if (op != set_operation::intersect) sink(std::as_const(*r.cur), static_cast<row_id_t>(r.pos), false);
+            r.skip(next_r, colnames, kinds);
+        } else {
+            if (op != set_operation::difference) sink(std::as_const(*l.cur), static_cast<row_id_t>(l.pos), true);
+            l.skip(next_l, colnames, kinds);
+            r.skip(next_r, colnames, kinds);
+        }
+    }
+    return l.valid && r.valid;
 }
 /** @brief data_frame_view represents a view of data_frame, and it only contains row index in original data_frame
  * 
@@ -1496,32 +2387,23 @@ template<class... Types>
 class data_frame_view {
 public:
     template<template<class...> class TypeLists, class... InnerTypes>
-    data_frame_view(data_frame<InnerTypes...>* df, std::vector<int>&& index, TypeLists<InnerTypes...>): 
-        data_frame_ptr(df), internal_index(std::move(index)) {}
+    data_frame_view(data_frame<InnerTypes...>* df, std::vector<row_id_t>&& index, TypeLists<InnerTypes...>): 
+        internal_index(index, frame_rows(df)), data_frame_ptr(df) {}
     template<template<class...> class TypeLists, class... InnerTypes>
-    data_frame_view(data_frame<InnerTypes...>* df, const std::vector<int>& index, TypeLists<InnerTypes...>) {
-        data_frame_ptr = df;
-        internal_index.clear();
-        int len = index.size();
-        for (int i = 0; i < len; i++)
-            internal_index.push_back(index[i]);
-    }
+    data_frame_view(data_frame<InnerTypes...>* df, const std::vector<row_id_t>& index, TypeLists<InnerTypes...>):
+        internal_index(index, frame_rows(df)), data_frame_ptr(df) {}
     template<template<class...> class TypeLists, class... InnerTypes>
-    data_frame_view(data_frame<InnerTypes...>* df, const slice& index, TypeLists<InnerTypes...>) {
+    data_frame_view(data_frame<InnerTypes...>* df, const slice& index, TypeLists<InnerTypes...>):
+        internal_index(frame_rows(df)) {
         data_frame_ptr = df;
-        internal_index.clear();
-        int len = index.size();
-        for (int i = 0; i < len; i++)
+        row_id_t len = index.size();
+        internal_index.reserve(len);
+        for (row_id_t i = 0; i < len; i++)
             internal_index.push_back(index(i));
     }
     template<template<class...> class TypeLists, class... InnerTypes>
-    data_frame_view(data_frame<InnerTypes...>* df, const range& index, TypeLists<InnerTypes...>) {
-        data_frame_ptr = df;
-        internal_index.clear();
-        int len = index.size();
-        for (int i = 0; i < len; i++)
-            internal_index.push_back(index(i));
-    }
+    data_frame_view(data_frame<InnerTypes...>* df, const range& index, TypeLists<InnerTypes...>):
+        internal_index(selection_vector::contiguous(index.start(), index.start() + index.size())), data_frame_ptr(df) {}
    /** @brief change existing value for specific indexes
     * 
     * @tparam F the functor type for applying
@@ -1531,7 +2413,7 @@ public:
     * @param f the functor to compute new value
     */   
     template<typename F>
-    data_frame_view<Types...>& apply_with_index(const std::vector<int>& index, F f) {
+    data_frame_view<Types...>& apply_with_index(const std::vector<row_id_t>& index, F f) {
         data_frame_ptr->apply_with_index(index, f);
         return *this;
     }
@@ -1539,7 +2421,7 @@ public:
     * 
     * @param index the index for printing
     */   
-    void print_with_index(const std::vector<int>& index) {
+    void print_with_index(const std::vector<row_id_t>& index) {
         data_frame_ptr->print_with_index(index);
     }
     /** @brief print for specific indexes
@@ -1584,7 +2466,7 @@ public:
         data_frame_ptr->data_frame<Types...>::template sort<T>(col_name, f);
         return *this;
     }
-    /** @brief create a view with rows only satisfying a condition 
+    /** @brief keep only the rows of this view satisfying a condition 
     * 
     * @tparam T the column type to be filtered
     * 
@@ -1597,7 +2479,25 @@ public:
     template<typename T, typename F>
     data_frame_view<Types...>& select(const std::string& col_name, F f) {
         static_assert(((std::is_same_v<T, Types> || ...)), "Type doesn't match to data_frame_view");
-        data_frame_ptr->data_frame<Types...>::template select<T>(col_name, f);
+        const auto* tmp_vector = data_frame_ptr->data_frame<Types...>::template get_column<T>(col_name);
+        if (!tmp_vector) {
+            internal_index.clear();
+            return *this;
+        }
+        // only the rows already in the view are tested
+        internal_index.retain([&](row_id_t row) { return f((*tmp_vector)[row]); });
+        return *this;
+    }
+    /** @brief keep rows satisfying a filter expression over several columns
+    * 
+    * @tparam E the filter expression type
+    * 
+    * @param e the filter expression
+    */   
+    template<typename E, typename = std::enable_if_t<is_filter_expression_v<E>>>
+    data_frame_view<Types...>& select(const E& e) {
+        auto bound = e.bind(*data_frame_ptr);
+        internal_index.retain([&](row_id_t row) { return bound.test(row); });
         return *this;
     }
     /** @brief return data with at pos row in col_name position
@@ -1628,18 +2528,503 @@ public:
     size_t get_cur_cols() {
         return data_frame_ptr->get_cur_cols();
     }
+    /** @brief return the rows of the data_frame in this view, in view order
+    */
+    const selection_vector& get_selection() const {
+        return internal_index;
+    }
 private: 
-    std::vector<int> internal_index;
+    template<class... InnerTypes>
+    static size_t frame_rows(const data_frame<InnerTypes...>* df) {
+        return df->get_cur_rows() > 0 ? df->get_cur_rows() : 0;
+    }
+    selection_vector internal_index;
     data_frame<Types...>* data_frame_ptr;
 };
 template<template<class...> class TypeLists, class... InnerTypes>
-data_frame_view(data_frame<InnerTypes...>* df, std::vector<int>&& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
+data_frame_view(data_frame<InnerTypes...>* df, std::vector<row_id_t>&& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
 template<template<class...> class TypeLists, class... InnerTypes>
-data_frame_view(data_frame<InnerTypes...>* df, const std::vector<int>& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
+data_frame_view(data_frame<InnerTypes...>* df, const std::vector<row_id_t>& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
 template<template<class...> class TypeLists, class... InnerTypes>
 data_frame_view(data_frame<InnerTypes...>* df, const slice& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
 template<template<class...> class TypeLists, class... InnerTypes>
 data_frame_view(data_frame<InnerTypes...>* df, const range& index, TypeLists<InnerTypes...>) -> data_frame_view<InnerTypes...>;
+/** @brief data_frame_join_view is the result of a join kept as pairs of rows of its two data_frames
+ *
+ * Nothing is copied when the view is built, a column is gathered from its data_frame as a whole only when it
+ * is asked for, so a join followed by a projection or an aggregation touches only the columns it uses. The
+ * data_frames must outlive the view.
+ *
+ * On the missing side of an unmatched row of an outer join a column is value-initialized, unless it is a key
+ * column, which takes the key from the other side.
+ *
+ * @tparam Left the data_frame on left
+ *
+ * @tparam Right the data_frame on right
+ */
+template<typename Left, typename Right>
+class data_frame_join_view {
+public:
+    /** @brief Build a view over joined rows
+    *
+    * @param l the data_frame on left
+    *
+    * @param r the data_frame on right
+    *
+    * @param pairs the joined rows
+    *
+    * @param left_keys the key columns of l
+    *
+    * @param right_keys the key columns of r
+    */
+    data_frame_join_view(const Left* l, const Right* r, join_pairs pairs,
+        std::vector<std::string> left_keys, std::vector<std::string> right_keys):
+        left_ptr(l), right_ptr(r), pairs(std::move(pairs)), left_keys(std::move(left_keys)), right_keys(std::move(right_keys)) {}
+    size_t get_cur_rows() const {
+        return pairs.size();
+    }
+    /** @brief row of the left data_frame joined at pos, @code null_row @endcode if there is none
+    */
+    row_id_t left_row(size_t pos) const {
+        return pairs.left[pos];
+    }
+    /** @brief row of the right data_frame joined at pos, @code null_row @endcode if there is none
+    */
+    row_id_t right_row(size_t pos) const {
+        return pairs.right[pos];
+    }
+    /** @brief return the joined rows of both data_frames, in view order
+    */
+    const join_pairs& get_pairs() const {
+        return pairs;
+    }
+    /** @brief gather a column of the left data_frame in view order, empty if it doesn't exist or has another type
+    *
+    * @tparam T the type for col_name column
+    *
+    * @param col_name the column name
+    *
+    * @param pool the threads gathering the column
+    */
+    template<typename T>
+    std::vector<T> left_column(const std::string& col_name, thread_pool& pool = default_thread_pool()) const {
+        return gather<T>(*left_ptr, pairs.left, *right_ptr, pairs.right, col_name, left_keys, right_keys, pool);
+    }
+    /** @brief gather a column of the right data_frame in view order, empty if it doesn't exist or has another type
+    *
+    * @tparam T the type for col_name column
+    *
+    * @param col_name the column name
+    *
+    * @param pool the threads gathering the column
+    */
+    template<typename T>
+    std::vector<T> right_column(const std::string& col_name, thread_pool& pool = default_thread_pool()) const {
+        return gather<T>(*right_ptr, pairs.right, *left_ptr, pairs.left, col_name, right_keys, left_keys, pool);
+    }
+    /** @brief create a new data_frame from some columns of both sides, the columns of the left data_frame first
+    *
+    * A name already taken by an earlier column is skipped.
+    *
+    * @param TypeLists1<InnerTypes1...> used to deduct the types of the left columns
+    *
+    * @param colnamesl the corresponding column names for each type position in TypeLists1<InnerTypes1...>
+    *
+    * @param TypeLists2<InnerTypes2...> used to deduct the types of the right columns
+    *
+    * @param colnamesr the corresponding column names for each type position in TypeLists2<InnerTypes2...>
+    *
+    * @param pool the threads gathering the columns
+    */
+    template<template<class...> class TypeLists1, class... InnerTypes1, template<class...> class TypeLists2, class... InnerTypes2>
+    auto to_data_frame(TypeLists1<InnerTypes1...>, const std::vector<std::string>& colnamesl,
+        TypeLists2<InnerTypes2...>, const std::vector<std::string>& colnamesr, thread_pool& pool = default_thread_pool()) const {
+        assert(sizeof...(InnerTypes1) == colnamesl.size());
+        assert(sizeof...(InnerTypes2) == colnamesr.size());
+        using type_collection = typename type_list<InnerTypes1..., InnerTypes2...>::types;
+        auto df = new data_frame(pairs.size(), type_collection{});
+        std::set<std::string> taken;
+        size_t i = 0;
+        ((taken.insert(colnamesl[i]).second ? df->add_column(colnamesl[i], left_column<InnerTypes1>(colnamesl[i], pool)) : void(), ++i), ...);
+        i = 0;
+        ((taken.insert(colnamesr[i]).second ? df->add_column(colnamesr[i], right_column<InnerTypes2>(colnamesr[i], pool)) : void(), ++i), ...);
+        return df;
+    }
+private:
+    template<typename T, typename Frame, typename Other>
+    static std::vector<T> gather(const Frame& df, const std::vector<row_id_t>& rows, const Other& other,
+        const std::vector<row_id_t>& other_rows, const std::string& col_name,
+        const std::vector<std::string>& keys, const std::vector<std::string>& other_keys, thread_pool& pool) {
+        const auto* col = df.template get_column<T>(col_name);
+        if (!col) return {};
+        const typename data_frame_col::store_type<T>* key = nullptr;
+        for (size_t k = 0; k < keys.size() && !key; k++)
+            if (keys[k] == col_name) key = other.template get_column<T>(other_keys[k]);
+        size_t n = rows.size();
+        std::vector<T> ans(n);
+        size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+        pool.parallel_for(tasks, [&](size_t t) {
+            for (size_t i = n * t / tasks; i < n * (t + 1) / tasks; i++) {
+                if (rows[i] != null_row) ans[i] = (*col)[rows[i]];
+                else if (key) ans[i] = (*key)[other_rows[i]];
+            }
+        });
+        return ans;
+    }
+    const Left* left_ptr;
+    const Right* right_ptr;
+    join_pairs pairs;
+    std::vector<std::string> left_keys;
+    std::vector<std::string> right_keys;
+};
+/** @brief join two data frames on specific column into a @code data_frame_join_view @endcode, rows are paired
+* by @code join_frame_pairs @endcode
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param kind which unmatched rows are kept
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*/
+template<typename T, typename... Types1, typename... Types2>
+auto join_view(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::string& col_name, join_kind kind = join_kind::inner, thread_pool* pool = nullptr) {
+    return data_frame_join_view<data_frame<Types1...>, data_frame<Types2...>>(&l, &r,
+        join_frame_pairs<T>(l, r, col_name, kind, pool), {col_name}, {col_name});
+}
+/** @brief join two data frames on several columns into a @code data_frame_join_view @endcode
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param left_keys the key columns of l
+*
+* @param right_keys the key columns of r, of the same types as left_keys
+*
+* @param kind which unmatched rows are kept
+*
+* @param pool the threads of a partitioned hash join, nullptr to join on the calling thread
+*/
+template<typename... Types1, typename... Types2>
+auto join_view(const data_frame<Types1...>& l, const data_frame<Types2...>& r,
+    const std::vector<std::string>& left_keys, const std::vector<std::string>& right_keys,
+    join_kind kind = join_kind::inner, thread_pool* pool = nullptr) {
+    return data_frame_join_view<data_frame<Types1...>, data_frame<Types2...>>(&l, &r,
+        join_frame_pairs(l, r, left_keys, right_keys, kind, pool), left_keys, right_keys);
+}
+/** @brief filter expression keeping the rows whose column col_name has a match in column r_col_name of r,
+* e.g. @code df.select(semi_join_filter<long>("id", orders, "customer") && col<double>("px") > 10) @endcode
+*
+* The keys of r are collected once into a @code join_key_set @endcode, the expression doesn't refer to r.
+*
+* @tparam T the type of both columns
+*
+* @param col_name the column of the filtered data_frame
+*
+* @param r the data_frame holding the keys
+*
+* @param r_col_name the key column of r
+*/
+template<typename T, typename... Types>
+key_set_condition<T> semi_join_filter(const std::string& col_name, const data_frame<Types...>& r, const std::string& r_col_name) {
+    const auto* rcol = r.data_frame<Types...>::template get_column<T>(r_col_name);
+    size_t n = rcol ? rcol->size() : 0;
+    return key_set_condition<T>(col_name, std::make_shared<const join_key_set<T>>(n ? &(*rcol)[0] : nullptr, n));
+}
+/** @brief filter expression keeping the rows whose column col_name has no match in column r_col_name of r
+*
+* @tparam T the type of both columns
+*
+* @param col_name the column of the filtered data_frame
+*
+* @param r the data_frame holding the keys
+*
+* @param r_col_name the key column of r
+*/
+template<typename T, typename... Types>
+not_expression<key_set_condition<T>> anti_join_filter(const std::string& col_name, const data_frame<Types...>& r, const std::string& r_col_name) {
+    return !semi_join_filter<T>(col_name, r, r_col_name);
+}
+/** @brief the rows of l having a match in r on column col_name, each once and in order
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*/
+template<typename T, typename... Types1, typename... Types2>
+data_frame_view<Types1...> semi_join(data_frame<Types1...>& l, const data_frame<Types2...>& r, const std::string& col_name) {
+    return l.select(semi_join_filter<T>(col_name, r, col_name));
+}
+/** @brief the rows of l without a match in r on column col_name, in order
+*
+* @tparam T the type of the column to be joined
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*/
+template<typename T, typename... Types1, typename... Types2>
+data_frame_view<Types1...> anti_join(data_frame<Types1...>& l, const data_frame<Types2...>& r, const std::string& col_name) {
+    return l.select(anti_join_filter<T>(col_name, r, col_name));
+}
+/** @brief as-of join two data frames on specific column into a @code data_frame_join_view @endcode, every left
+* row is paired with the nearest right row before or after it, or with none
+*
+* Both key columns are merged in ascending order, a column not known to be ascending is sorted first. The
+* rows come in left row order.
+*
+* @tparam T the arithmetic type of the column to be joined, e.g. a timestamp
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param options the direction, an optional column matched exactly and an optional tolerance
+*
+* @param pool the threads sorting unsorted key columns
+*
+* @return an empty view when the key or by column is missing or of another type on either side
+*/
+template<typename T, typename... Types1, typename... Types2>
+auto asof_join(const data_frame<Types1...>& l, const data_frame<Types2...>& r, const std::string& col_name,
+    const asof_options<T>& options = {}, thread_pool& pool = default_thread_pool()) {
+    using view_type = data_frame_join_view<data_frame<Types1...>, data_frame<Types2...>>;
+    const auto* lcol = l.data_frame<Types1...>::template get_column<T>(col_name);
+    const auto* rcol = r.data_frame<Types2...>::template get_column<T>(col_name);
+    if (!lcol || !rcol) return view_type(&l, &r, join_pairs{}, {}, {});
+    size_t nl = lcol->size(), nr = rcol->size();
+    detail::ascending_column<T> lkeys(nl ? &(*lcol)[0] : nullptr, nl, l.get_sort_order(col_name) == sort_order::ascending, pool);
+    detail::ascending_column<T> rkeys(nr ? &(*rcol)[0] : nullptr, nr, r.get_sort_order(col_name) == sort_order::ascending, pool);
+    // the by column is reduced to group numbers, taken in the merge order
+    std::vector<row_id_t> left_group, right_group;
+    size_t groups = 0;
+    if (!options.by.empty()) {
+        auto number = [&](auto* tag) {
+            using B = std::remove_pointer_t<decltype(tag)>;
+            const auto* lby = l.data_frame<Types1...>::template get_column<B>(options.by);
+            const auto* rby = r.data_frame<Types2...>::template get_column<B>(options.by);
+            if (!lby || !rby) return false;
+            groups = join_groups(column_join_key<B>(nl ? &(*lby)[0] : nullptr, nl, nr ? &(*rby)[0] : nullptr, nr), left_group, right_group);
+            return true;
+        };
+        if (!(number(static_cast<Types1*>(nullptr)) || ...)) return view_type(&l, &r, join_pairs{}, {}, {});
+        std::vector<row_id_t> tmp(nl);
+        for (size_t i = 0; i < nl; i++) tmp[i] = left_group[lkeys.row(i)];
+        left_group.swap(tmp);
+        tmp.resize(nr);
+        for (size_t j = 0; j < nr; j++) tmp[j] = right_group[rkeys.row(j)];
+        right_group.swap(tmp);
+    }
+    auto matched = asof_merge(lkeys.values, nl, rkeys.values, nr,
+        options.by.empty() ? nullptr : left_group.data(), options.by.empty() ? nullptr : right_group.data(), groups,
+        options.direction, options.tolerance);
+    join_pairs pairs;
+    pairs.left.resize(nl);
+    pairs.right.resize(nl);
+    for (size_t i = 0; i < nl; i++) {
+        row_id_t row = lkeys.row(i);
+        pairs.left[row] = row;
+        pairs.right[row] = matched[i] == null_row ? null_row : rkeys.row(matched[i]);
+    }
+    std::vector<std::string> keys;
+    if (!options.by.empty()) keys.push_back(options.by);
+    return view_type(&l, &r, std::move(pairs), keys, keys);
+}
+/** @brief band join two data frames on specific column into a @code data_frame_join_view @endcode, pairing
+* the rows whose keys are at most delta apart
+*
+* Both key columns are merged in ascending order, a column not known to be ascending is sorted first. The
+* rows come in the order of @code hash_join @endcode.
+*
+* @tparam T the arithmetic type of the column to be joined, e.g. a timestamp
+*
+* @param l the data_frame on left
+*
+* @param r the data_frame on right
+*
+* @param col_name the name of column to be joined on
+*
+* @param delta the largest distance between matched keys
+*
+* @param kind which unmatched rows are kept
+*
+* @param pool the threads sorting unsorted key columns
+*
+* @return an empty view when the key column is missing or of another type on either side
+*/
+template<typename T, typename... Types1, typename... Types2>
+auto band_join(const data_frame<Types1...>& l, const data_frame<Types2...>& r, const std::string& col_name,
+    T delta, join_kind kind = join_kind::inner, thread_pool& pool = default_thread_pool()) {
+    using view_type = data_frame_join_view<data_frame<Types1...>, data_frame<Types2...>>;
+    const auto* lcol = l.data_frame<Types1...>::template get_column<T>(col_name);
+    const auto* rcol = r.data_frame<Types2...>::template get_column<T>(col_name);
+    if (!lcol || !rcol) return view_type(&l, &r, join_pairs{}, {}, {});
+    size_t nl = lcol->size(), nr = rcol->size();
+    detail::ascending_column<T> lkeys(nl ? &(*lcol)[0] : nullptr, nl, l.get_sort_order(col_name) == sort_order::ascending, pool);
+    detail::ascending_column<T> rkeys(nr ? &(*rcol)[0] : nullptr, nr, r.get_sort_order(col_name) == sort_order::ascending, pool);
+    join_pairs pairs = band_merge(lkeys.values, nl, rkeys.values, nr, delta, kind);
+    if (!lkeys.rows.empty() || !rkeys.rows.empty()) {
+        // back to row numbers, then to left row order with the right rows of a left row ascending
+        for (size_t i = 0; i < pairs.size(); i++) {
+            if (pairs.left[i] != null_row) pairs.left[i] = lkeys.row(pairs.left[i]);
+            if (pairs.right[i] != null_row) pairs.right[i] = rkeys.row(pairs.right[i]);
+        }
+        std::vector<size_t> order(pairs.size());
+        std::iota(order.begin(), order.end(), 0);
+        auto key = [&pairs](size_t i) {
+            return std::make_pair(static_cast<std::make_unsigned_t<row_id_t>>(pairs.left[i]), pairs.right[i]);
+        };
+        std::sort(order.begin(), order.end(), [&key](size_t a, size_t b) { return key(a) < key(b); });
+        join_pairs sorted;
+        sorted.left.reserve(pairs.size());
+        sorted.right.reserve(pairs.size());
+        for (size_t i: order) {
+            sorted.left.push_back(pairs.left[i]);
+            sorted.right.push_back(pairs.right[i]);
+        }
+        pairs = std::move(sorted);
+    }
+    return view_type(&l, &r, std::move(pairs), std::vector<std::string>{}, std::vector<std::string>{});
+}
+/** @brief data_frame_group_by holds the rows of a data_frame grouped on some key columns
+ *
+ * Rows are put in groups by an open-addressing hash table on their key hash, keys are compared on the columns
+ * themselves. Groups are numbered in first-seen order, a row with NaN in a key column belongs to none.
+ *
+ * @tparam Types... the template argument of the data_frame
+ */
+template<class... Types>
+class data_frame_group_by {
+public:
+    /** @brief the types of the frame aggregations are written to: the types of the data_frame, double for means,
+    * size_t for counts and the 64-bit integers sums of integer columns are written in, see @code sum_type @endcode
+    */
+    using result_types = boost::mp11::mp_unique<std::tuple<Types..., double, std::size_t, std::int64_t, std::uint64_t>>;
+    using result_type = boost::mp11::mp_rename<result_types, data_frame>;
+    /** @brief group the rows of @code df @endcode on @code keys @endcode, all rows in one group if there is no key
+    *
+    * @param pool the threads hashing the keys
+    */
+    data_frame_group_by(const data_frame<Types...>* df, const std::vector<std::string>& keys,
+        thread_pool& pool = default_thread_pool()): df(df), keys(keys) {
+        size_t n = std::max<row_id_t>(df->get_cur_rows(), 0);
+        using key_type = boost::mp11::mp_rename<typename type_list<Types...>::types, composite_join_key>;
+        key_type key(n, 0);
+        std::vector<unsigned char> no_group(n, 0);
+        for (const auto& name: keys) {
+            auto add = [&](auto* tag) {
+                using T = std::remove_pointer_t<decltype(tag)>;
+                const auto* tmp_vector = df->template get_column<T>(name);
+                if (!tmp_vector) return false;
+                const T* data = n ? &(*tmp_vector)[0] : nullptr;
+                key.add_column(data, static_cast<const T*>(nullptr), pool);
+                if constexpr (std::is_floating_point_v<T>) {
+                    for (size_t i = 0; i < n; i++) no_group[i] |= std::isnan(data[i]);
+                }
+                return true;
+            };
+            valid = valid && (add(static_cast<Types*>(nullptr)) || ...);
+        }
+        if (!valid) return;
+        std::vector<row_id_t> rows;
+        std::vector<std::uint64_t> hashes;
+        rows.reserve(n);
+        hashes.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            if (no_group[i]) continue;
+            rows.push_back(static_cast<row_id_t>(i));
+            hashes.push_back(key.hash_left(static_cast<row_id_t>(i)));
+        }
+        join_hash_table table;
+        table.build(rows.size(), hashes.data(), [&](row_id_t a, row_id_t b) { return key.equal_left(rows[a], rows[b]); });
+        row_group.assign(n, null_row);
+        for (size_t i = 0; i < rows.size(); i++) row_group[rows[i]] = table.group_of(static_cast<row_id_t>(i));
+        group_first.resize(table.groups());
+        for (size_t g = 0; g < table.groups(); g++)
+            group_first[g] = rows[*table.group_rows(static_cast<row_id_t>(g)).first];
+    }
+    /** @brief number of groups
+    */
+    size_t groups() const { return group_first.size(); }
+    /** @brief group of row @code row @endcode, @code null_row @endcode if it has NaN in a key column
+    */
+    row_id_t group_of(row_id_t row) const { return row_group[row]; }
+    /** @brief aggregate every group into one row of a new data_frame, in group order
+    *
+    * The key columns come first with the values of the group, then one column per aggregation.
+    *
+    * @param aggregates the aggregations, like @code sum("qty") @endcode
+    *
+    * @return nullptr when a column is missing, a function doesn't apply to the type of its column (sum or mean
+    * of strings) or two output columns have the same name
+    */
+    result_type* agg(const std::vector<aggregate>& aggregates) const {
+        if (!valid) return nullptr;
+        size_t n = row_group.size(), m = groups();
+        auto ans = std::make_unique<result_type>(m, result_types{});
+        std::set<std::string> taken;
+        for (const auto& name: keys) {
+            if (!taken.insert(name).second) continue;
+            auto gather = [&](auto* tag) {
+                using T = std::remove_pointer_t<decltype(tag)>;
+                const auto* tmp_vector = df->template get_column<T>(name);
+                if (!tmp_vector) return false;
+                std::vector<T> values(m);
+                for (size_t g = 0; g < m; g++) values[g] = (*tmp_vector)[group_first[g]];
+                ans->add_column(name, std::move(values));
+                return true;
+            };
+            (gather(static_cast<Types*>(nullptr)) || ...);
+        }
+        for (const auto& a: aggregates) {
+            if (!taken.insert(a.name).second) return nullptr;
+            if (a.kind == aggregate_kind::count && a.column.empty()) {
+                std::vector<std::size_t> counts(m, 0);
+                for (size_t i = 0; i < n; i++)
+                    if (row_group[i] != null_row) ++counts[row_group[i]];
+                ans->add_column(a.name, std::move(counts));
+                continue;
+            }
+            bool applied = false;
+            auto fold = [&](auto* tag) {
+                using T = std::remove_pointer_t<decltype(tag)>;
+                const auto* tmp_vector = df->template get_column<T>(a.column);
+                if (!tmp_vector) return false;
+                if (!(applied = aggregate_states<T>::applies(a.kind))) return true;
+                aggregate_states<T> states(a.kind, m);
+                states.update(n ? &(*tmp_vector)[0] : nullptr, row_group.data(), n);
+                if (a.kind == aggregate_kind::sum) ans->add_column(a.name, states.take_sums());
+                else if (a.kind == aggregate_kind::mean) ans->add_column(a.name, states.take_means());
+                else if (a.kind == aggregate_kind::count) ans->add_column(a.name, states.take_counts());
+                else ans->add_column(a.name, states.take_values());
+                return true;
+            };
+            if (!(fold(static_cast<Types*>(nullptr)) || ...) || !applied) return nullptr;
+        }
+        return ans.release();
+    }
+private:
+    const data_frame<Types...>* df;
+    std::vector<std::string> keys;
+    std::vector<row_id_t> row_group;
+    std::vector<row_id_t> group_first;
+    bool valid = true;
+};
 }}}
 
 #endif
\ No newline at end of file
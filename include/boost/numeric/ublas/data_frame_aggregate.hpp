@@ -0,0 +1,178 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_AGGREGATE_
+#define _BOOST_UBLAS_DATA_FRAME_AGGREGATE_
+#include "data_frame_selection.hpp"
+#include "data_frame_index.hpp"
+#include "data_frame_join.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief aggregate functions of @code data_frame_group_by::agg @endcode
+ */
+enum class aggregate_kind { sum, mean, count, min, max, first };
+/** @brief one aggregation of every group: a function, the column it reads and the column it writes
+ *
+ * Made by @code sum @endcode, @code mean @endcode, @code count @endcode, @code min @endcode, @code max @endcode
+ * and @code first @endcode. The output column is named after the column and the function, e.g. "qty_sum",
+ * unless renamed with @code as @endcode.
+ */
+struct aggregate {
+    /** @brief the same aggregation writing the column @code output @endcode
+    */
+    aggregate as(const std::string& output) const { return {kind, column, output}; }
+    aggregate_kind kind;
+    std::string column;
+    std::string name;
+};
+/** @brief sum of a column, NaN left out, see @code sum_type @endcode for its type
+ */
+inline aggregate sum(const std::string& column) { return {aggregate_kind::sum, column, column + "_sum"}; }
+/** @brief mean of a column as double, NaN left out, NaN for a group without values
+ */
+inline aggregate mean(const std::string& column) { return {aggregate_kind::mean, column, column + "_mean"}; }
+/** @brief number of rows of a group, or of its values other than NaN when a column is given
+ */
+inline aggregate count(const std::string& column = "") {
+    return {aggregate_kind::count, column, column.empty() ? "count" : column + "_count"};
+}
+/** @brief smallest value of a column, NaN left out, NaN for a group without values
+ */
+inline aggregate min(const std::string& column) { return {aggregate_kind::min, column, column + "_min"}; }
+/** @brief largest value of a column, NaN left out, NaN for a group without values
+ */
+inline aggregate max(const std::string& column) { return {aggregate_kind::max, column, column + "_max"}; }
+/** @brief value of a column in the first row of a group
+ */
+inline aggregate first(const std::string& column) { return {aggregate_kind::first, column, column + "_first"}; }
+/** @brief the type sums of a column of type T are accumulated and written in: 64-bit integers of the same
+ * signedness for integer columns, which don't overflow where the column type would, and T otherwise
+ */
+template<typename T, typename = void>
+struct sum_type {
+    using type = T;
+};
+template<typename T>
+struct sum_type<T, std::enable_if_t<std::is_integral_v<T>>> {
+    using type = std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>;
+};
+template<typename T>
+using sum_type_t = typename sum_type<T>::type;
+/** @brief aggregate_states holds the state of one aggregation for all groups in flat arrays, one per field
+ *
+ * Only the arrays the function needs are allocated: the running sum in @code sum_type_t<T> @endcode, the running
+ * value for min, max and first, the running total for mean and the number of values for count, mean, min and max. Rows are folded in one pass over the
+ * column, so a group costs a few array slots and no allocation of its own.
+ *
+ * @tparam T the type of the aggregated column
+ */
+template<typename T>
+class aggregate_states {
+public:
+    /** @brief Build the states of @code groups @endcode empty groups
+    */
+    aggregate_states(aggregate_kind kind, size_t groups): kind(kind), groups(groups) {
+        if (kind == aggregate_kind::mean) totals.assign(groups, 0.0);
+        else if (kind == aggregate_kind::sum) sums.assign(groups, sum_type_t<T>());
+        else if (kind != aggregate_kind::count) values.assign(groups, T());
+        if (kind != aggregate_kind::sum && kind != aggregate_kind::first) counts.assign(groups, 0);
+        if (kind == aggregate_kind::first) seen.assign(groups, 0);
+    }
+    /** @brief whether the function applies to columns of type T
+    */
+    static bool applies(aggregate_kind kind) {
+        if (kind == aggregate_kind::sum || kind == aggregate_kind::mean) return std::is_arithmetic_v<T>;
+        if (kind == aggregate_kind::min || kind == aggregate_kind::max) return is_less_comparable<T>::value;
+        return true;
+    }
+    /** @brief fold rows [0, n) of a column into the states of their groups
+    *
+    * @param data the column
+    *
+    * @param row_group the group of every row, rows of @code null_row @endcode are left out
+    *
+    * @param n number of rows
+    */
+    void update(const T* data, const row_id_t* row_group, size_t n) {
+        auto valid = [](const T& v) {
+            if constexpr (std::is_floating_point_v<T>) return !std::isnan(v);
+            else return true;
+        };
+        switch (kind) {
+        case aggregate_kind::sum:
+            if constexpr (std::is_arithmetic_v<T>) {
+                for (size_t i = 0; i < n; i++)
+                    if (row_group[i] != null_row && valid(data[i])) sums[row_group[i]] += data[i];
+            }
+            break;
+        case aggregate_kind::mean:
+            if constexpr (std::is_arithmetic_v<T>) {
+                for (size_t i = 0; i < n; i++) {
+                    if (row_group[i] == null_row || !valid(data[i])) continue;
+                    totals[row_group[i]] += static_cast<double>(data[i]);
+                    ++counts[row_group[i]];
+                }
+            }
+            break;
+        case aggregate_kind::count:
+            for (size_t i = 0; i < n; i++)
+                if (row_group[i] != null_row && valid(data[i])) ++counts[row_group[i]];
+            break;
+        case aggregate_kind::min:
+        case aggregate_kind::max:
+            if constexpr (is_less_comparable<T>::value) {
+                bool is_min = kind == aggregate_kind::min;
+                for (size_t i = 0; i < n; i++) {
+                    row_id_t g = row_group[i];
+                    if (g == null_row || !valid(data[i])) continue;
+                    if (!counts[g]++ || (is_min ? data[i] < values[g] : values[g] < data[i])) values[g] = data[i];
+                }
+            }
+            break;
+        case aggregate_kind::first:
+            for (size_t i = 0; i < n; i++) {
+                row_id_t g = row_group[i];
+                if (g == null_row || seen[g]) continue;
+                seen[g] = 1;
+                values[g] = data[i];
+            }
+            break;
+        }
+    }
+    /** @brief the sum of every group
+    */
+    std::vector<sum_type_t<T>> take_sums() { return std::move(sums); }
+    /** @brief the value of every group for min, max and first
+    */
+    std::vector<T> take_values() {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (kind == aggregate_kind::min || kind == aggregate_kind::max)
+                for (size_t g = 0; g < groups; g++)
+                    if (!counts[g]) values[g] = std::numeric_limits<T>::quiet_NaN();
+        }
+        return std::move(values);
+    }
+    /** @brief the mean of every group
+    */
+    std::vector<double> take_means() {
+        for (size_t g = 0; g < groups; g++)
+            totals[g] = counts[g] ? totals[g] / counts[g] : std::numeric_limits<double>::quiet_NaN();
+        return std::move(totals);
+    }
+    /** @brief the number of values of every group
+    */
+    std::vector<std::size_t> take_counts() { return std::move(counts); }
+private:
+    aggregate_kind kind;
+    size_t groups;
+    std::vector<sum_type_t<T>> sums;
+    std::vector<T> values;
+    std::vector<double> totals;
+    std::vector<std::size_t> counts;
+    std::vector<unsigned char> seen;
+};
+}}}
+#endif
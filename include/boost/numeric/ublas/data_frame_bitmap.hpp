@@ -0,0 +1,211 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_BITMAP_
+#define _BOOST_UBLAS_DATA_FRAME_BITMAP_
+#include "data_frame_predicate.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief roaring_bitmap is a compressed set of row numbers in the style of Roaring bitmaps
+ *
+ * Rows are split by their high bits into chunks of 65536 rows. A sparse chunk stores its low 16 bits in
+ * a sorted array, a dense chunk (more than 4096 rows) stores a 65536-bit bitset. Intersections, unions
+ * and cardinalities work chunk by chunk without expanding the set.
+ */
+class roaring_bitmap {
+public:
+    static constexpr size_t array_limit = 4096;
+    static constexpr size_t bitset_words = 65536 / 64;
+    /** @brief add a row, appending rows in ascending order is the fast path
+    *
+    * @param row the row number
+    */
+    void add(std::uint64_t row) {
+        std::uint64_t key = row >> 16;
+        std::uint16_t low = static_cast<std::uint16_t>(row & 0xFFFF);
+        if (keys.empty() || keys.back() < key) {
+            keys.push_back(key);
+            containers.emplace_back();
+            containers.back().add(low);
+            return;
+        }
+        auto iter = std::lower_bound(keys.begin(), keys.end(), key);
+        size_t pos = iter - keys.begin();
+        if (*iter != key) {
+            keys.insert(iter, key);
+            containers.insert(containers.begin() + pos, container());
+        }
+        containers[pos].add(low);
+    }
+    bool contains(std::uint64_t row) const {
+        auto iter = std::lower_bound(keys.begin(), keys.end(), row >> 16);
+        if (iter == keys.end() || *iter != (row >> 16)) return false;
+        return containers[iter - keys.begin()].contains(static_cast<std::uint16_t>(row & 0xFFFF));
+    }
+    /** @brief number of rows in the set
+    */
+    size_t cardinality() const {
+        size_t n = 0;
+        for (const auto& c: containers) n += c.card;
+        return n;
+    }
+    bool empty() const { return containers.empty(); }
+    /** @brief call @code f(row) @endcode for every row in ascending order
+    */
+    template<typename F>
+    void for_each(F f) const {
+        for (size_t i = 0; i < keys.size(); i++) {
+            std::uint64_t base = keys[i] << 16;
+            const auto& c = containers[i];
+            if (!c.is_bitset) {
+                for (auto low: c.array) f(base | low);
+            } else {
+                for (size_t w = 0; w < bitset_words; w++) {
+                    for (std::uint64_t bits = c.bits[w]; bits; bits &= bits - 1)
+                        f(base | (w * 64 + detail::countr_zero64(bits)));
+                }
+            }
+        }
+    }
+    /** @brief expand into ascending row indexes
+    */
+    std::vector<row_id_t> to_index() const {
+        std::vector<row_id_t> index;
+        index.reserve(cardinality());
+        for_each([&index](std::uint64_t row) { index.push_back(static_cast<row_id_t>(row)); });
+        return index;
+    }
+    roaring_bitmap& operator&=(const roaring_bitmap& other) {
+        roaring_bitmap ans;
+        size_t i = 0, j = 0;
+        while (i < keys.size() && j < other.keys.size()) {
+            if (keys[i] < other.keys[j]) ++i;
+            else if (keys[i] > other.keys[j]) ++j;
+            else {
+                container c = intersect(containers[i], other.containers[j]);
+                if (c.card) {
+                    ans.keys.push_back(keys[i]);
+                    ans.containers.push_back(std::move(c));
+                }
+                ++i;
+                ++j;
+            }
+        }
+        return *this = std::move(ans);
+    }
+    roaring_bitmap& operator|=(const roaring_bitmap& other) {
+        roaring_bitmap ans;
+        size_t i = 0, j = 0;
+        while (i < keys.size() || j < other.keys.size()) {
+            if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j])) {
+                ans.keys.push_back(keys[i]);
+                ans.containers.push_back(std::move(containers[i++]));
+            } else if (i == keys.size() || keys[i] > other.keys[j]) {
+                ans.keys.push_back(other.keys[j]);
+                ans.containers.push_back(other.containers[j++]);
+            } else {
+                ans.keys.push_back(keys[i]);
+                ans.containers.push_back(unite(containers[i++], other.containers[j++]));
+            }
+        }
+        return *this = std::move(ans);
+    }
+private:
+    struct container {
+        bool is_bitset = false;
+        size_t card = 0;
+        std::vector<std::uint16_t> array;
+        std::vector<std::uint64_t> bits;
+        void add(std::uint16_t low) {
+            if (is_bitset) {
+                std::uint64_t& w = bits[low / 64];
+                std::uint64_t mask = std::uint64_t(1) << (low % 64);
+                card += !(w & mask);
+                w |= mask;
+                return;
+            }
+            if (array.empty() || array.back() < low) {
+                array.push_back(low);
+            } else {
+                auto iter = std::lower_bound(array.begin(), array.end(), low);
+                if (*iter == low) return;
+                array.insert(iter, low);
+            }
+            ++card;
+            if (card > array_limit) to_bitset();
+        }
+        bool contains(std::uint16_t low) const {
+            if (is_bitset) return (bits[low / 64] >> (low % 64)) & 1;
+            return std::binary_search(array.begin(), array.end(), low);
+        }
+        void to_bitset() {
+            bits.assign(bitset_words, 0);
+            for (auto low: array) bits[low / 64] |= std::uint64_t(1) << (low % 64);
+            array.clear();
+            array.shrink_to_fit();
+            is_bitset = true;
+        }
+        void to_array() {
+            array.clear();
+            array.reserve(card);
+            for (size_t w = 0; w < bitset_words; w++) {
+                for (std::uint64_t b = bits[w]; b; b &= b - 1)
+                    array.push_back(static_cast<std::uint16_t>(w * 64 + detail::countr_zero64(b)));
+            }
+            bits.clear();
+            bits.shrink_to_fit();
+            is_bitset = false;
+        }
+    };
+    static container intersect(const container& l, const container& r) {
+        container ans;
+        if (l.is_bitset && r.is_bitset) {
+            ans.is_bitset = true;
+            ans.bits.resize(bitset_words);
+            for (size_t w = 0; w < bitset_words; w++) {
+                ans.bits[w] = l.bits[w] & r.bits[w];
+                ans.card += detail::popcount64(ans.bits[w]);
+            }
+            if (ans.card <= array_limit) ans.to_array();
+        } else if (l.is_bitset || r.is_bitset) {
+            const container& a = l.is_bitset ? r : l;
+            const container& b = l.is_bitset ? l : r;
+            for (auto low: a.array)
+                if (b.contains(low)) ans.array.push_back(low);
+            ans.card = ans.array.size();
+        } else {
+            std::set_intersection(l.array.begin(), l.array.end(), r.array.begin(), r.array.end(),
+                                  std::back_inserter(ans.array));
+            ans.card = ans.array.size();
+        }
+        return ans;
+    }
+    static container unite(const container& l, const container& r) {
+        container ans;
+        if (!l.is_bitset && !r.is_bitset) {
+            std::set_union(l.array.begin(), l.array.end(), r.array.begin(), r.array.end(),
+                           std::back_inserter(ans.array));
+            ans.card = ans.array.size();
+            if (ans.card > array_limit) ans.to_bitset();
+            return ans;
+        }
+        ans.is_bitset = true;
+        ans.bits.assign(bitset_words, 0);
+        for (const container* c: {&l, &r}) {
+            if (c->is_bitset) {
+                for (size_t w = 0; w < bitset_words; w++) ans.bits[w] |= c->bits[w];
+            } else {
+                for (auto low: c->array) ans.bits[low / 64] |= std::uint64_t(1) << (low % 64);
+            }
+        }
+        for (auto w: ans.bits) ans.card += detail::popcount64(w);
+        return ans;
+    }
+    std::vector<std::uint64_t> keys;
+    std::vector<container> containers;
+};
+inline roaring_bitmap operator&(roaring_bitmap l, const roaring_bitmap& r) { return l &= r; }
+inline roaring_bitmap operator|(roaring_bitmap l, const roaring_bitmap& r) { return l |= r; }
+}}}
+
+#endif
@@ -2,6 +2,7 @@
 #define _BOOST_UBLAS_DATA_FRAME_COL_
 #include <boost/mp11/algorithm.hpp>
 #include <boost/numeric/ublas/vector.hpp>
+#include "data_frame_selection.hpp"
 #include <unordered_map>
 #include <functional>
 #include <vector>
@@ -69,7 +70,7 @@ public:
     * @tparam T type of the objects stored in the data_frame_col
     */
     template<typename T> 
-    int get_size() {
+    row_id_t get_size() {
         if (vals<T>.count(this))
             return vals<T>[this].size();
         else return 0;
@@ -81,6 +82,7 @@ public:
     template<typename T>
     T& at(size_t index) {
         // need to handle exception here
+        ++version;
         return vals<T>[this][index];
     }
     /** @brief Get a const reference for data stored at index in @code data_frame_col @endcode
@@ -99,6 +101,7 @@ public:
     data_frame_col& operator=(const data_frame_col& _other)
     {
         clear();
+        version = _other.version;
         clear_functions = _other.clear_functions;
         copy_functions = _other.copy_functions;
         size_functions = _other.size_functions;
@@ -117,6 +120,7 @@ public:
     */
     template<typename T>
     store_type<T>& get_vector() {
+        ++version;
         return vals<T>[this];
     }
     /** @brief get a const underlying container from @code data_frame_col @endcode
@@ -144,12 +148,35 @@ public:
     * @param TypeLists<Types...> used to deduct types
     */
     template<typename F, template<class...> class TypeLists, typename... Types>
-    void fill_data_at(int index, const std::string& col_name, F&& f, TypeLists<Types...>) {
-        (..., [this, functor = std::move(f)](int i, const std::string& name) mutable {
+    void fill_data_at(row_id_t index, const std::string& col_name, F&& f, TypeLists<Types...>) {
+        (..., [this, functor = std::move(f)](row_id_t i, const std::string& name) mutable {
             if (vals<Types>[this].size() > 0)
                 functor(at<Types>(i), name);
         }(index, col_name));
     }
+    /** @brief read value at specific position for specific column in @code data_frame_col @endcode
+    *
+    * @tparam F functor reading the value, requires a const value and column name
+    * 
+    * @tparam TypeLists a set of potential types, used as @code TypeLists<Types...> @endcode
+    * 
+    * @tparam Types... a typelists containing concrete types in @code TypeLists<Types...> @endcode
+    * 
+    * @param index the position to read
+    * 
+    * @param col_name name for current @code data_frame_col @endcode
+    * 
+    * @param f functor reading the value
+    * 
+    * @param TypeLists<Types...> used to deduct types
+    */
+    template<typename F, template<class...> class TypeLists, typename... Types>
+    void fill_data_at(row_id_t index, const std::string& col_name, F&& f, TypeLists<Types...>) const {
+        (..., [this, &f](row_id_t i, const std::string& name) {
+            if (vals<Types>[this].size() > 0)
+                f(at<Types>(i), name);
+        }(index, col_name));
+    }
     /** @brief initialize values for @code data_frame_col @endcode
     *
     * @tparam F functor to initiliaze new value, requires original value to deduct type
@@ -184,13 +211,37 @@ public:
     * @param TypeLists<Types...> used to deduct types
     */
     template<typename F, template<class...> class TypeLists, typename... Types>
-    void apply_at(int index, F&& f, TypeLists<Types...>) {
-        (..., [this, functor = std::move(f)](int i) {
+    void apply_at(row_id_t index, F&& f, TypeLists<Types...>) {
+        ++version;
+        (..., [this, functor = std::move(f)](row_id_t i) {
             if (vals<Types>[this].size() > 0) 
                 functor(vals<Types>[this][i]);
         }(index));
     }
+    /** @brief read value at specific position within @code data_frame_col @endcode
+    *
+    * @tparam F functor reading the value
+    * 
+    * @tparam TypeLists a set of potential types, used as @code TypeLists<Types...> @endcode
+    * 
+    * @tparam Types... a typelists containing concrete types in @code TypeLists<Types...> @endcode
+    * 
+    * @param index the position to read
+    * 
+    * @param f functor reading the value
+    * 
+    * @param TypeLists<Types...> used to deduct types
+    */
+    template<typename F, template<class...> class TypeLists, typename... Types>
+    void apply_at(row_id_t index, F&& f, TypeLists<Types...>) const {
+        (..., [this, &f](row_id_t i) {
+            if (vals<Types>[this].size() > 0) 
+                f(static_cast<const store_type<Types>&>(vals<Types>[this])[i]);
+        }(index));
+    }
     std::string col_name;
+    /* bumped by every non-const access, data derived from the column records the version it was built from */
+    size_t version = 0;
 private:
     void clear() {
         for (auto&& clear_func : clear_functions) {
@@ -215,10 +266,11 @@ void data_frame_col::build_by_vec(std::string col_name, const std::vector<T>& ot
         });
         size_functions.emplace_back([](const data_frame_col& _c){return vals<T>[&_c].size();});
     }
-    int len = other.size();
+    row_id_t len = other.size();
+    ++version;
     vals<T>[this] = store_type<T>(len);
     this->col_name = col_name;
-    for (int i = 0; i < len; i++) {
+    for (row_id_t i = 0; i < len; i++) {
         vals<T>[this](i) = other[i];
     }
 }
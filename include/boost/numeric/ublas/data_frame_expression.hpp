@@ -0,0 +1,271 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_EXPRESSION_
+#define _BOOST_UBLAS_DATA_FRAME_EXPRESSION_
+#include "data_frame_index.hpp"
+#include "data_frame_join.hpp"
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief base class for filter expressions over several columns,
+ * e.g. @code col<double>("px") > 10 && col<long>("qty") < 500 @endcode
+ *
+ * An expression is bound to a @code data_frame @endcode once, resolving every column name,
+ * and then evaluated in one fused pass over blocks of rows. When every condition is on a column
+ * with a bitmap index, @code bitmap @endcode answers it by combining bitmaps instead.
+ *
+ * @tparam E the derived expression type
+ */
+template<typename E>
+struct filter_expression {
+    const E& self() const { return static_cast<const E&>(*this); }
+};
+template<typename E>
+constexpr bool is_filter_expression_v = std::is_base_of_v<filter_expression<std::decay_t<E>>, std::decay_t<E>>;
+/** @brief number of rows evaluated together, conjunctions skip the right side for words already zero
+ */
+constexpr size_t filter_block_rows = 1024;
+/** @brief a condition on a single column, the leaf of a filter expression
+ *
+ * @tparam T the column type
+ *
+ * @tparam Pred a built-in predicate from data_frame_predicate.hpp
+ */
+template<typename T, typename Pred>
+struct column_condition: filter_expression<column_condition<T, Pred>> {
+    column_condition(std::string name, Pred pred): col_name(std::move(name)), pred(std::move(pred)) {}
+    struct bound {
+        const T* data;
+        const zone_map<T>* zones;
+        Pred pred;
+        void eval(size_t first, size_t n, selection_mask::word_type* out) const {
+            if (!data) {
+                std::fill(out, out + (n + selection_mask::word_bits - 1) / selection_mask::word_bits, 0);
+                return;
+            }
+            evaluate_predicate_with_zones(data, first, n, pred, zones, out);
+        }
+        bool test(size_t row) const { return data && pred(data[row]); }
+    };
+    template<typename DF>
+    bound bind(const DF& df) const {
+        const auto* vec = df.template get_column<T>(col_name);
+        if (!vec || !vec->size()) return bound{nullptr, nullptr, pred};
+        return bound{&(*vec)[0], df.template get_zone_map<T>(col_name), pred};
+    }
+    template<typename DF>
+    std::optional<roaring_bitmap> bitmap(const DF& df) const {
+        const auto* index = df.template get_bitmap_index<T>(col_name);
+        if (!index) return std::nullopt;
+        return index->lookup(pred);
+    }
+    std::string col_name;
+    Pred pred;
+};
+template<typename L, typename R>
+struct and_expression: filter_expression<and_expression<L, R>> {
+    and_expression(L l, R r): l(std::move(l)), r(std::move(r)) {}
+    template<typename BL, typename BR>
+    struct bound {
+        BL l;
+        BR r;
+        void eval(size_t first, size_t n, selection_mask::word_type* out) const {
+            constexpr size_t word_bits = selection_mask::word_bits;
+            l.eval(first, n, out);
+            size_t words = (n + word_bits - 1) / word_bits;
+            for (size_t w = 0; w < words; w++) {
+                if (!out[w]) continue;
+                selection_mask::word_type rbits;
+                r.eval(first + w * word_bits, std::min(word_bits, n - w * word_bits), &rbits);
+                out[w] &= rbits;
+            }
+        }
+        bool test(size_t row) const { return l.test(row) && r.test(row); }
+    };
+    template<typename DF>
+    auto bind(const DF& df) const {
+        auto bl = l.bind(df);
+        auto br = r.bind(df);
+        return bound<decltype(bl), decltype(br)>{std::move(bl), std::move(br)};
+    }
+    template<typename DF>
+    std::optional<roaring_bitmap> bitmap(const DF& df) const {
+        auto bl = l.bitmap(df);
+        if (!bl) return std::nullopt;
+        auto br = r.bitmap(df);
+        if (!br) return std::nullopt;
+        *bl &= *br;
+        return bl;
+    }
+    L l;
+    R r;
+};
+template<typename L, typename R>
+struct or_expression: filter_expression<or_expression<L, R>> {
+    or_expression(L l, R r): l(std::move(l)), r(std::move(r)) {}
+    template<typename BL, typename BR>
+    struct bound {
+        BL l;
+        BR r;
+        void eval(size_t first, size_t n, selection_mask::word_type* out) const {
+            constexpr size_t word_bits = selection_mask::word_bits;
+            l.eval(first, n, out);
+            size_t words = (n + word_bits - 1) / word_bits;
+            for (size_t w = 0; w < words; w++) {
+                size_t len = std::min(word_bits, n - w * word_bits);
+                selection_mask::word_type full = len == word_bits ? ~selection_mask::word_type(0) :
+                                                 (selection_mask::word_type(1) << len) - 1;
+                if (out[w] == full) continue;
+                selection_mask::word_type rbits;
+                r.eval(first + w * word_bits, len, &rbits);
+                out[w] |= rbits;
+            }
+        }
+        bool test(size_t row) const { return l.test(row) || r.test(row); }
+    };
+    template<typename DF>
+    auto bind(const DF& df) const {
+        auto bl = l.bind(df);
+        auto br = r.bind(df);
+        return bound<decltype(bl), decltype(br)>{std::move(bl), std::move(br)};
+    }
+    template<typename DF>
+    std::optional<roaring_bitmap> bitmap(const DF& df) const {
+        auto bl = l.bitmap(df);
+        if (!bl) return std::nullopt;
+        auto br = r.bitmap(df);
+        if (!br) return std::nullopt;
+        *bl |= *br;
+        return bl;
+    }
+    L l;
+    R r;
+};
+template<typename E>
+struct not_expression: filter_expression<not_expression<E>> {
+    explicit not_expression(E e): e(std::move(e)) {}
+    template<typename BE>
+    struct bound {
+        BE e;
+        void eval(size_t first, size_t n, selection_mask::word_type* out) const {
+            constexpr size_t word_bits = selection_mask::word_bits;
+            e.eval(first, n, out);
+            size_t words = (n + word_bits - 1) / word_bits;
+            for (size_t w = 0; w < words; w++) out[w] = ~out[w];
+            if (n % word_bits) out[words - 1] &= (selection_mask::word_type(1) << (n % word_bits)) - 1;
+        }
+        bool test(size_t row) const { return !e.test(row); }
+    };
+    template<typename DF>
+    auto bind(const DF& df) const {
+        auto be = e.bind(df);
+        return bound<decltype(be)>{std::move(be)};
+    }
+    /* a complement needs the full row set, negations are evaluated on the column data */
+    template<typename DF>
+    std::optional<roaring_bitmap> bitmap(const DF&) const { return std::nullopt; }
+    E e;
+};
+/** @brief membership of a column's values in the keys of another data_frame, the filter form of a semi join,
+ * negate it for an anti join
+ *
+ * @tparam T the column type
+ */
+template<typename T>
+struct key_set_condition: filter_expression<key_set_condition<T>> {
+    key_set_condition(std::string name, std::shared_ptr<const join_key_set<T>> keys): col_name(std::move(name)), keys(std::move(keys)) {}
+    struct bound {
+        const T* data;
+        const join_key_set<T>* keys;
+        void eval(size_t first, size_t n, selection_mask::word_type* out) const {
+            if (!data) {
+                std::fill(out, out + (n + selection_mask::word_bits - 1) / selection_mask::word_bits, 0);
+                return;
+            }
+            evaluate_predicate(data + first, n, [this](const T& v) { return keys->contains(v); }, out);
+        }
+        bool test(size_t row) const { return data && keys->contains(data[row]); }
+    };
+    template<typename DF>
+    bound bind(const DF& df) const {
+        const auto* vec = df.template get_column<T>(col_name);
+        if (!vec || !vec->size()) return bound{nullptr, keys.get()};
+        return bound{&(*vec)[0], keys.get()};
+    }
+    template<typename DF>
+    std::optional<roaring_bitmap> bitmap(const DF&) const { return std::nullopt; }
+    std::string col_name;
+    std::shared_ptr<const join_key_set<T>> keys;
+};
+/** @brief a named, typed column reference used to build filter expressions
+ *
+ * @tparam T the column type
+ */
+template<typename T>
+struct column_ref {
+    std::string col_name;
+    template<typename U>
+    auto between(U low, U high) const {
+        return column_condition<T, between_values<U>>(col_name, between_values<U>(std::move(low), std::move(high)));
+    }
+    template<typename U>
+    auto in(std::initializer_list<U> values) const {
+        return column_condition<T, in_values<U>>(col_name, in_values<U>(std::vector<U>(values)));
+    }
+    template<typename U>
+    auto in(std::vector<U> values) const {
+        return column_condition<T, in_values<U>>(col_name, in_values<U>(std::move(values)));
+    }
+};
+/** @brief refer to column @code col_name @endcode of type T inside a filter expression
+ */
+template<typename T>
+column_ref<T> col(std::string col_name) {
+    return column_ref<T>{std::move(col_name)};
+}
+template<typename T, typename U>
+auto operator<(const column_ref<T>& c, U v) { return column_condition<T, less_than<U>>(c.col_name, less_than<U>(std::move(v))); }
+template<typename T, typename U>
+auto operator<=(const column_ref<T>& c, U v) { return column_condition<T, less_equal<U>>(c.col_name, less_equal<U>(std::move(v))); }
+template<typename T, typename U>
+auto operator>(const column_ref<T>& c, U v) { return column_condition<T, greater_than<U>>(c.col_name, greater_than<U>(std::move(v))); }
+template<typename T, typename U>
+auto operator>=(const column_ref<T>& c, U v) { return column_condition<T, greater_equal<U>>(c.col_name, greater_equal<U>(std::move(v))); }
+template<typename T, typename U>
+auto operator==(const column_ref<T>& c, U v) { return column_condition<T, equal_to<U>>(c.col_name, equal_to<U>(std::move(v))); }
+template<typename L, typename R>
+and_expression<L, R> operator&&(const filter_expression<L>& l, const filter_expression<R>& r) {
+    return and_expression<L, R>(l.self(), r.self());
+}
+template<typename L, typename R>
+or_expression<L, R> operator||(const filter_expression<L>& l, const filter_expression<R>& r) {
+    return or_expression<L, R>(l.self(), r.self());
+}
+template<typename E>
+not_expression<E> operator!(const filter_expression<E>& e) {
+    return not_expression<E>(e.self());
+}
+/** @brief evaluate a filter expression against a data_frame in one fused pass
+ *
+ * @tparam DF the data_frame type
+ *
+ * @tparam E the expression type
+ *
+ * @param df the data_frame providing the columns
+ *
+ * @param e the expression
+ */
+template<typename DF, typename E>
+selection_mask evaluate_filter(const DF& df, const filter_expression<E>& e) {
+    size_t len = df.get_cur_rows() > 0 ? df.get_cur_rows() : 0;
+    selection_mask ans(len);
+    auto bound = e.self().bind(df);
+    for (size_t first = 0; first < len; first += filter_block_rows) {
+        bound.eval(first, std::min(filter_block_rows, len - first), ans.words() + first / selection_mask::word_bits);
+    }
+    return ans;
+}
+}}}
+
+#endif
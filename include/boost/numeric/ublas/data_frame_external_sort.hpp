@@ -0,0 +1,479 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_EXTERNAL_SORT_
+#define _BOOST_UBLAS_DATA_FRAME_EXTERNAL_SORT_
+#include <boost/mp11/algorithm.hpp>
+#include "data_frame.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <typeinfo>
+#include <variant>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief settings of an @code external_sorter @endcode
+ */
+struct external_sort_options {
+    /* bytes of column data buffered before they are sorted and spilled as a run */
+    size_t memory_budget = size_t(64) << 20;
+    /* directory of the run files, the system temporary directory when empty */
+    std::string temp_dir;
+    /* rows per block of a run file, merging holds one block of every run in memory */
+    size_t block_rows = 4096;
+};
+namespace detail {
+/* three-way comparison of two values of a sort key, NaN placed as the key asks */
+template<typename T>
+int compare_sort_key(const T& l, const T& r, const sort_key& key) {
+    if constexpr (std::is_floating_point_v<T>) {
+        bool ln = std::isnan(l), rn = std::isnan(r);
+        if (ln || rn) {
+            if (ln == rn) return 0;
+            return (ln == (key.nulls == null_order::first)) ? -1 : 1;
+        }
+    }
+    int c = l < r ? -1 : (r < l ? 1 : 0);
+    return key.ascending ? c : -c;
+}
+}
+/** @brief external_sorter sorts a stream of @code data_frame @endcode chunks that doesn't fit in memory
+ *
+ * Pushed chunks are buffered column by column. Once the buffer holds more than the memory budget it's sorted
+ * on the thread pool and spilled to a temporary run file. Merging reads the runs back block by block and
+ * k-way merges them into a sequence of data_frames or into one sorted file. Rows with equal keys keep the
+ * order they were pushed in.
+ *
+ * A run file is binary and columnar: a header with the column names and types, then blocks of rows each
+ * storing one column after the other. Arithmetic values are written raw in native byte order, strings as
+ * their lengths followed by their bytes.
+ *
+ * @tparam Types... the column types, trivially copyable or @code std::string @endcode
+ */
+template<class... Types>
+class external_sorter {
+    static_assert(((std::is_trivially_copyable_v<Types> || std::is_same_v<Types, std::string>) && ...),
+                  "external_sorter needs trivially copyable or string columns");
+    template<typename T>
+    using column_vector = std::vector<T>;
+public:
+    /* the buffered values of one column */
+    using column_data = boost::mp11::mp_rename<boost::mp11::mp_transform<column_vector, typename type_list<Types...>::types>, std::variant>;
+    /** @brief Build an external_sorter ordering rows by @code keys @endcode
+    *
+    * @param keys the sort columns, most significant first, arithmetic or @code std::string @endcode
+    *
+    * @param options memory budget, temporary directory and block size
+    *
+    * @param pool the threads sorting every run
+    */
+    explicit external_sorter(std::vector<sort_key> keys, external_sort_options options = {}, thread_pool& pool = default_thread_pool()):
+        keys(std::move(keys)), options(std::move(options)), pool(pool) {
+        if (!this->options.block_rows) this->options.block_rows = 1;
+    }
+    external_sorter(const external_sorter&) = delete;
+    external_sorter& operator=(const external_sorter&) = delete;
+    ~external_sorter() {
+        remove_runs();
+    }
+    /** @brief add the rows of @code chunk @endcode, sorting and spilling the buffer when it's over the budget
+    *
+    * The first chunk fixes the columns, later chunks must have the same names and types.
+    *
+    * @param chunk the rows to add
+    *
+    * @return false when the columns don't match, a key column is missing or a run couldn't be written
+    */
+    bool push(const data_frame<Types...>& chunk) {
+        if (names.empty() && !init_schema(chunk)) return false;
+        if (chunk.get_cur_rows() <= 0) return true;
+        std::vector<std::string> chunk_names = chunk.get_col_names();
+        std::sort(chunk_names.begin(), chunk_names.end());
+        if (chunk_names != names) return false;
+        for (size_t i = 0; i < names.size(); i++) {
+            bool same_type = std::visit([&](const auto& vec) {
+                return chunk.template get_column<typename std::decay_t<decltype(vec)>::value_type>(names[i]) != nullptr;
+            }, buffer[i]);
+            if (!same_type) return false;
+        }
+        for (size_t i = 0; i < names.size(); i++) {
+            std::visit([&](auto& vec) {
+                using T = typename std::decay_t<decltype(vec)>::value_type;
+                const auto& col = *chunk.template get_column<T>(names[i]);
+                vec.insert(vec.end(), col.begin(), col.end());
+                if constexpr (std::is_same_v<T, std::string>) {
+                    for (const auto& s: col) buffered_bytes += sizeof(T) + s.size();
+                } else {
+                    buffered_bytes += sizeof(T) * col.size();
+                }
+            }, buffer[i]);
+        }
+        buffered_rows += chunk.get_cur_rows();
+        if (buffered_bytes >= options.memory_budget) return spill();
+        return true;
+    }
+    /** @brief number of runs spilled so far
+    */
+    size_t runs() const { return run_files.size(); }
+    /** @brief merge everything pushed so far and hand it to @code sink @endcode in order, then start over empty
+    *
+    * When nothing was spilled the rows are sorted in memory without touching the disk.
+    *
+    * @tparam F functor taking a @code data_frame<Types...>& @endcode
+    *
+    * @param sink called with consecutive chunks of the sorted rows
+    *
+    * @param chunk_rows rows per chunk, the last one may be shorter
+    *
+    * @return false when a run couldn't be written or read back
+    */
+    template<typename F>
+    bool merge(F sink, size_t chunk_rows = 65536) {
+        return merge_runs(std::max<size_t>(1, chunk_rows), [this, &sink](std::vector<column_data>& cols, size_t) {
+            data_frame<Types...> df;
+            for (size_t i = 0; i < names.size(); i++)
+                std::visit([&](auto& vec) { df.add_column(names[i], std::move(vec)); }, cols[i]);
+            sink(df);
+            return true;
+        });
+    }
+    /** @brief merge everything pushed so far into the run file @code path @endcode, then start over empty
+    *
+    * @param path the output file, readable with @code for_each_chunk @endcode
+    *
+    * @return false when a file couldn't be written or read back
+    */
+    bool merge_to_file(const std::string& path) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        write_header(out);
+        bool ok = merge_runs(options.block_rows, [&out](std::vector<column_data>& cols, size_t rows) {
+            write_block(out, cols, nullptr, 0, rows);
+            return bool(out);
+        });
+        return ok && out.flush();
+    }
+    /** @brief read a run file back as a sequence of data_frames, one per block
+    *
+    * @tparam F functor taking a @code data_frame<Types...>& @endcode
+    *
+    * @param path a file written by @code merge_to_file @endcode
+    *
+    * @param sink called with every block in order
+    *
+    * @return false when the file is missing, damaged or holds a type that isn't one of Types...
+    */
+    template<typename F>
+    static bool for_each_chunk(const std::string& path, F sink) {
+        run_reader reader;
+        if (!reader.open(path)) return false;
+        while (reader.next_block()) {
+            data_frame<Types...> df;
+            for (size_t i = 0; i < reader.names.size(); i++)
+                std::visit([&](auto& vec) { df.add_column(reader.names[i], std::move(vec)); }, reader.block[i]);
+            sink(df);
+        }
+        return reader.good();
+    }
+private:
+    static constexpr char magic[8] = {'D', 'F', 'R', 'U', 'N', '0', '0', '1'};
+    /* reads the blocks of one run file */
+    struct run_reader {
+        bool open(const std::string& path) {
+            in.open(path, std::ios::binary);
+            char head[sizeof(magic)];
+            if (!in.read(head, sizeof(head)) || std::memcmp(head, magic, sizeof(magic))) return false;
+            std::uint64_t cols = 0;
+            if (!read_pod(in, cols)) return false;
+            for (std::uint64_t i = 0; i < cols; i++) {
+                std::string name, type_name;
+                if (!read_string(in, name) || !read_string(in, type_name)) return false;
+                column_data empty;
+                bool known = ((type_name == typeid(Types).name() && (empty = column_vector<Types>(), true)) || ...);
+                if (!known) return false;
+                names.push_back(std::move(name));
+                block.push_back(std::move(empty));
+            }
+            return true;
+        }
+        /* load the next block, false at the end of the file or on an error */
+        bool next_block() {
+            pos = 0;
+            rows = 0;
+            std::uint64_t n = 0;
+            if (!read_pod(in, n)) {
+                damaged = !in.eof();
+                return false;
+            }
+            for (auto& col: block) {
+                bool ok = std::visit([&](auto& vec) {
+                    using T = typename std::decay_t<decltype(vec)>::value_type;
+                    vec.resize(n);
+                    if constexpr (std::is_same_v<T, std::string>) {
+                        std::vector<std::uint64_t> lengths(n);
+                        if (!read_bytes(in, lengths.data(), n * sizeof(std::uint64_t))) return false;
+                        for (size_t i = 0; i < n; i++) {
+                            vec[i].resize(lengths[i]);
+                            if (!read_bytes(in, vec[i].data(), lengths[i])) return false;
+                        }
+                        return true;
+                    } else {
+                        return read_bytes(in, vec.data(), n * sizeof(T));
+                    }
+                }, col);
+                if (!ok) {
+                    damaged = true;
+                    return false;
+                }
+            }
+            rows = n;
+            return rows > 0 || next_block();
+        }
+        bool good() const { return in.is_open() && !damaged; }
+        std::ifstream in;
+        std::vector<std::string> names;
+        std::vector<column_data> block;
+        size_t rows = 0;
+        size_t pos = 0;
+        bool damaged = false;
+    };
+public:
+    /** @brief pulls the blocks of a run file one at a time, e.g. as a source of @code merge_set_operation @endcode
+    */
+    class chunk_reader {
+    public:
+        /** @brief open the run file @code path @endcode written by @code merge_to_file @endcode
+        */
+        explicit chunk_reader(const std::string& path) : opened(reader.open(path)) {}
+        /** @brief fill the empty @code chunk @endcode with the next block, false at the end or on an error
+        */
+        bool operator()(data_frame<Types...>& chunk) {
+            if (!opened || !reader.next_block()) return false;
+            for (size_t i = 0; i < reader.names.size(); i++)
+                std::visit([&](auto& vec) { chunk.add_column(reader.names[i], std::move(vec)); }, reader.block[i]);
+            return true;
+        }
+        /** @brief false when the file was missing or damaged
+        */
+        bool good() const { return opened && reader.good(); }
+    private:
+        run_reader reader;
+        bool opened;
+    };
+private:
+    template<typename T>
+    static bool read_pod(std::istream& in, T& v) {
+        return bool(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+    }
+    static bool read_bytes(std::istream& in, void* p, size_t n) {
+        return !n || bool(in.read(static_cast<char*>(p), n));
+    }
+    static bool read_string(std::istream& in, std::string& s) {
+        std::uint64_t n = 0;
+        if (!read_pod(in, n)) return false;
+        s.resize(n);
+        return read_bytes(in, s.data(), n);
+    }
+    static void write_string(std::ostream& out, const std::string& s) {
+        std::uint64_t n = s.size();
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        out.write(s.data(), n);
+    }
+    void write_header(std::ostream& out) const {
+        out.write(magic, sizeof(magic));
+        std::uint64_t cols = names.size();
+        out.write(reinterpret_cast<const char*>(&cols), sizeof(cols));
+        for (size_t i = 0; i < names.size(); i++) {
+            write_string(out, names[i]);
+            std::visit([&out](const auto& vec) {
+                write_string(out, typeid(typename std::decay_t<decltype(vec)>::value_type).name());
+            }, buffer[i]);
+        }
+    }
+    /* write rows [first, last) of cols, taken through index when it's given */
+    static void write_block(std::ostream& out, const std::vector<column_data>& cols, const std::vector<row_id_t>* index, size_t first, size_t last) {
+        std::uint64_t n = last - first;
+        out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        auto row = [index](size_t i) { return index ? static_cast<size_t>((*index)[i]) : i; };
+        for (const auto& col: cols) {
+            std::visit([&](const auto& vec) {
+                using T = typename std::decay_t<decltype(vec)>::value_type;
+                if constexpr (std::is_same_v<T, std::string>) {
+                    std::vector<std::uint64_t> lengths;
+                    lengths.reserve(n);
+                    for (size_t i = first; i < last; i++) lengths.push_back(vec[row(i)].size());
+                    out.write(reinterpret_cast<const char*>(lengths.data()), n * sizeof(std::uint64_t));
+                    for (size_t i = first; i < last; i++) out.write(vec[row(i)].data(), vec[row(i)].size());
+                } else if (!index) {
+                    out.write(reinterpret_cast<const char*>(vec.data() + first), n * sizeof(T));
+                } else {
+                    std::vector<T> gathered;
+                    gathered.reserve(n);
+                    for (size_t i = first; i < last; i++) gathered.push_back(vec[row(i)]);
+                    out.write(reinterpret_cast<const char*>(gathered.data()), n * sizeof(T));
+                }
+            }, col);
+        }
+    }
+    bool init_schema(const data_frame<Types...>& chunk) {
+        std::vector<std::string> chunk_names = chunk.get_col_names();
+        std::sort(chunk_names.begin(), chunk_names.end());
+        std::vector<column_data> cols;
+        for (const auto& name: chunk_names) {
+            column_data empty;
+            bool found = ((chunk.template get_column<Types>(name) && (empty = column_vector<Types>(), true)) || ...);
+            if (!found) return false;
+            cols.push_back(std::move(empty));
+        }
+        std::vector<size_t> positions;
+        for (const auto& key: keys) {
+            auto iter = std::lower_bound(chunk_names.begin(), chunk_names.end(), key.col_name);
+            if (iter == chunk_names.end() || *iter != key.col_name) return false;
+            size_t pos = iter - chunk_names.begin();
+            bool supported = std::visit([](const auto& vec) {
+                return normalized_keys::is_supported_v<typename std::decay_t<decltype(vec)>::value_type>;
+            }, cols[pos]);
+            if (!supported) return false;
+            positions.push_back(pos);
+        }
+        names = std::move(chunk_names);
+        buffer = std::move(cols);
+        key_columns = std::move(positions);
+        return true;
+    }
+    std::vector<row_id_t> sort_buffer() const {
+        normalized_keys normalized(buffered_rows);
+        for (size_t k = 0; k < keys.size(); k++) {
+            std::visit([&](const auto& vec) {
+                using T = typename std::decay_t<decltype(vec)>::value_type;
+                if constexpr (normalized_keys::is_supported_v<T>)
+                    normalized.add_column(vec.data(), keys[k].ascending, keys[k].nulls);
+            }, buffer[key_columns[k]]);
+        }
+        return normalized.argsort(true, pool);
+    }
+    void clear_buffer() {
+        for (auto& col: buffer) std::visit([](auto& vec) { std::decay_t<decltype(vec)>().swap(vec); }, col);
+        buffered_rows = 0;
+        buffered_bytes = 0;
+    }
+    std::string next_run_path() const {
+        static const auto salt = std::random_device{}();
+        std::filesystem::path dir = options.temp_dir.empty() ? std::filesystem::temp_directory_path() : std::filesystem::path(options.temp_dir);
+        std::string file = "data_frame_sort_" + std::to_string(salt) + "_" + std::to_string(reinterpret_cast<std::uintptr_t>(this)) +
+                           "_" + std::to_string(run_files.size()) + ".run";
+        return (dir / file).string();
+    }
+    /* sort the buffer and write it as a new run */
+    bool spill() {
+        if (!buffered_rows) return true;
+        auto index = sort_buffer();
+        std::string path = next_run_path();
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        run_files.push_back(path);
+        write_header(out);
+        for (size_t first = 0; first < buffered_rows; first += options.block_rows)
+            write_block(out, buffer, &index, first, std::min(buffered_rows, first + options.block_rows));
+        clear_buffer();
+        return bool(out.flush());
+    }
+    void remove_runs() {
+        std::error_code ec;
+        for (const auto& path: run_files) std::filesystem::remove(path, ec);
+        run_files.clear();
+    }
+    int compare_rows(const std::vector<column_data>& l, size_t li, const std::vector<column_data>& r, size_t ri) const {
+        for (size_t k = 0; k < keys.size(); k++) {
+            int c = std::visit([&](const auto& lv) {
+                using V = std::decay_t<decltype(lv)>;
+                return detail::compare_sort_key(lv[li], std::get<V>(r[key_columns[k]])[ri], keys[k]);
+            }, l[key_columns[k]]);
+            if (c) return c;
+        }
+        return 0;
+    }
+    static void append_row(std::vector<column_data>& out, const std::vector<column_data>& in, size_t row) {
+        for (size_t i = 0; i < out.size(); i++)
+            std::visit([&](auto& vec) { vec.push_back(std::get<std::decay_t<decltype(vec)>>(in[i])[row]); }, out[i]);
+    }
+    std::vector<column_data> empty_columns() const {
+        std::vector<column_data> cols;
+        for (const auto& col: buffer) cols.push_back(std::visit([](const auto& vec) { return column_data(std::decay_t<decltype(vec)>()); }, col));
+        return cols;
+    }
+    /* hand the sorted rows to emit in chunks of out_rows, then reset to the empty state */
+    template<typename Emit>
+    bool merge_runs(size_t out_rows, Emit emit) {
+        bool ok = true;
+        if (run_files.empty()) {
+            auto index = sort_buffer();
+            for (size_t first = 0; first < buffered_rows && ok; first += out_rows) {
+                size_t last = std::min(buffered_rows, first + out_rows);
+                auto cols = empty_columns();
+                for (size_t c = 0; c < cols.size(); c++) {
+                    std::visit([&](auto& vec) {
+                        const auto& in = std::get<std::decay_t<decltype(vec)>>(buffer[c]);
+                        vec.reserve(last - first);
+                        for (size_t i = first; i < last; i++) vec.push_back(in[index[i]]);
+                    }, cols[c]);
+                }
+                ok = emit(cols, last - first);
+            }
+            clear_buffer();
+            return ok;
+        }
+        if (!spill()) {
+            remove_runs();
+            clear_buffer();
+            return false;
+        }
+        std::vector<run_reader> readers(run_files.size());
+        for (size_t r = 0; r < readers.size() && ok; r++) ok = readers[r].open(run_files[r]) && readers[r].names == names;
+        // the run pushed first wins ties, which keeps equal keys in push order
+        auto after = [this, &readers](size_t a, size_t b) {
+            int c = compare_rows(readers[a].block, readers[a].pos, readers[b].block, readers[b].pos);
+            return c > 0 || (c == 0 && a > b);
+        };
+        std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+        for (size_t r = 0; r < readers.size() && ok; r++) {
+            if (readers[r].next_block()) heap.push(r);
+            ok = readers[r].good();
+        }
+        auto cols = empty_columns();
+        size_t rows = 0;
+        while (ok && !heap.empty()) {
+            size_t r = heap.top();
+            heap.pop();
+            append_row(cols, readers[r].block, readers[r].pos);
+            if (++readers[r].pos < readers[r].rows || readers[r].next_block()) heap.push(r);
+            ok = readers[r].good();
+            if (ok && ++rows == out_rows) {
+                ok = emit(cols, rows);
+                cols = empty_columns();
+                rows = 0;
+            }
+        }
+        if (ok && rows) ok = emit(cols, rows);
+        readers.clear();
+        remove_runs();
+        return ok;
+    }
+    std::vector<sort_key> keys;
+    external_sort_options options;
+    thread_pool& pool;
+    std::vector<std::string> names;
+    std::vector<size_t> key_columns;
+    std::vector<column_data> buffer;
+    size_t buffered_rows = 0;
+    size_t buffered_bytes = 0;
+    std::vector<std::string> run_files;
+};
+}}}
+
+#endif
@@ -0,0 +1,465 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_INDEX_
+#define _BOOST_UBLAS_DATA_FRAME_INDEX_
+#include "data_frame_predicate.hpp"
+#include "data_frame_bitmap.hpp"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief number of rows summarized by one zone map entry, a multiple of the filter block size
+ */
+constexpr size_t zone_map_block_rows = 4096;
+/** @brief result of testing a predicate against the value range of a block
+ */
+enum class zone_match { none, some, all };
+/** @brief zone_map keeps the minimum and maximum of every fixed-size block of an arithmetic column,
+ * range predicates use it to skip blocks without reading them.
+ *
+ * @tparam T an arithmetic column type
+ */
+template<typename T>
+struct zone_map {
+    /** @brief rebuild the statistics from the column data
+    *
+    * @param data first value of the column
+    *
+    * @param n number of values
+    *
+    * @param col_version version of the column the statistics are built from
+    */
+    void build(const T* data, size_t n, size_t col_version) {
+        size_t blocks = (n + zone_map_block_rows - 1) / zone_map_block_rows;
+        mins.assign(blocks, T{});
+        maxs.assign(blocks, T{});
+        unordered.assign(blocks, 0);
+        for (size_t b = 0; b < blocks; b++) {
+            const T* first = data + b * zone_map_block_rows;
+            const T* last = data + std::min(n, (b + 1) * zone_map_block_rows);
+            T lo = *first, hi = *first;
+            bool has_nan = false;
+            for (const T* p = first; p != last; ++p) {
+                if constexpr (std::is_floating_point_v<T>) {
+                    if (std::isnan(*p)) {
+                        has_nan = true;
+                        continue;
+                    }
+                    if (std::isnan(lo)) lo = hi = *p;
+                }
+                lo = *p < lo ? *p : lo;
+                hi = *p > hi ? *p : hi;
+            }
+            mins[b] = lo;
+            maxs[b] = hi;
+            unordered[b] = has_nan;
+        }
+        rows = n;
+        version = col_version;
+        valid = true;
+    }
+    /** @brief test a built-in predicate against block @code b @endcode
+    */
+    template<typename Pred>
+    zone_match test(size_t b, const Pred& p) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            // an all-NaN block has NaN bounds and can't match any comparison
+            if (std::isnan(mins[b])) return zone_match::none;
+        }
+        zone_match ans = zone_test(p, mins[b], maxs[b]);
+        if (ans == zone_match::all && unordered[b]) return zone_match::some;
+        return ans;
+    }
+    size_t block_count() const { return mins.size(); }
+    std::vector<T> mins;
+    std::vector<T> maxs;
+    /* blocks containing NaN, they are never reported as fully matching */
+    std::vector<unsigned char> unordered;
+    size_t rows = 0;
+    size_t version = 0;
+    bool valid = false;
+};
+template<typename T, typename U>
+zone_match zone_test(const less_than<U>& p, const T& lo, const T& hi) {
+    if (hi < p.value) return zone_match::all;
+    return lo < p.value ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const less_equal<U>& p, const T& lo, const T& hi) {
+    if (hi <= p.value) return zone_match::all;
+    return lo <= p.value ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const greater_than<U>& p, const T& lo, const T& hi) {
+    if (lo > p.value) return zone_match::all;
+    return hi > p.value ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const greater_equal<U>& p, const T& lo, const T& hi) {
+    if (lo >= p.value) return zone_match::all;
+    return hi >= p.value ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const equal_to<U>& p, const T& lo, const T& hi) {
+    if (lo == p.value && hi == p.value) return zone_match::all;
+    return lo <= p.value && p.value <= hi ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const between_values<U>& p, const T& lo, const T& hi) {
+    if (lo >= p.low && hi <= p.high) return zone_match::all;
+    return hi >= p.low && lo <= p.high ? zone_match::some : zone_match::none;
+}
+template<typename T, typename U>
+zone_match zone_test(const in_values<U>& p, const T& lo, const T& hi) {
+    auto iter = std::lower_bound(p.values.begin(), p.values.end(), lo);
+    if (iter == p.values.end() || *iter > hi) return zone_match::none;
+    return lo == hi ? zone_match::all : zone_match::some;
+}
+/** @brief known order of a column's values, @code none @endcode when unknown or unsorted
+ */
+enum class sort_order { none, ascending, descending };
+template<typename T, typename = void>
+struct is_less_comparable: std::false_type {};
+template<typename T>
+struct is_less_comparable<T, std::void_t<decltype(std::declval<const T&>() < std::declval<const T&>())>>: std::true_type {};
+/** @brief check whether @code n @endcode values follow @code order @endcode, floating point data containing NaN never does
+ */
+template<typename T>
+bool is_sorted_as(const T* data, size_t n, sort_order order) {
+    if constexpr (!is_less_comparable<T>::value) {
+        return false;
+    } else {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::any_of(data, data + n, [](T x) { return std::isnan(x); })) return false;
+        }
+        if (order == sort_order::ascending) return std::is_sorted(data, data + n);
+        if (order == sort_order::descending) return std::is_sorted(data, data + n, [](const T& l, const T& r) { return r < l; });
+        return false;
+    }
+}
+/** @brief check whether @code n @endcode values are sorted, ascending is reported for constant data,
+ * floating point data containing NaN is never reported as sorted
+ */
+template<typename T>
+sort_order detect_sort_order(const T* data, size_t n) {
+    if (is_sorted_as(data, n, sort_order::ascending)) return sort_order::ascending;
+    if (is_sorted_as(data, n, sort_order::descending)) return sort_order::descending;
+    return sort_order::none;
+}
+/* predicates selecting one contiguous run of a sorted column; range_below(p, x) tells whether x sorts before
+ * the run and range_above(p, x) whether it sorts after it, in ascending order */
+template<typename Pred>
+struct is_range_predicate: std::false_type {};
+template<typename U> struct is_range_predicate<less_than<U>>: std::true_type {};
+template<typename U> struct is_range_predicate<less_equal<U>>: std::true_type {};
+template<typename U> struct is_range_predicate<greater_than<U>>: std::true_type {};
+template<typename U> struct is_range_predicate<greater_equal<U>>: std::true_type {};
+template<typename U> struct is_range_predicate<equal_to<U>>: std::true_type {};
+template<typename U> struct is_range_predicate<between_values<U>>: std::true_type {};
+template<typename U, typename T> bool range_below(const less_than<U>&, const T&) { return false; }
+template<typename U, typename T> bool range_above(const less_than<U>& p, const T& x) { return !(x < p.value); }
+template<typename U, typename T> bool range_below(const less_equal<U>&, const T&) { return false; }
+template<typename U, typename T> bool range_above(const less_equal<U>& p, const T& x) { return !(x <= p.value); }
+template<typename U, typename T> bool range_below(const greater_than<U>& p, const T& x) { return !(x > p.value); }
+template<typename U, typename T> bool range_above(const greater_than<U>&, const T&) { return false; }
+template<typename U, typename T> bool range_below(const greater_equal<U>& p, const T& x) { return !(x >= p.value); }
+template<typename U, typename T> bool range_above(const greater_equal<U>&, const T&) { return false; }
+template<typename U, typename T> bool range_below(const equal_to<U>& p, const T& x) { return x < p.value; }
+template<typename U, typename T> bool range_above(const equal_to<U>& p, const T& x) { return p.value < x; }
+template<typename U, typename T> bool range_below(const between_values<U>& p, const T& x) { return x < p.low; }
+template<typename U, typename T> bool range_above(const between_values<U>& p, const T& x) { return p.high < x; }
+/** @brief rows [first, last) of a sorted column satisfying a range predicate, found by binary search
+ *
+ * @param data first value of the column
+ *
+ * @param n number of values
+ *
+ * @param order the order of the column, ascending or descending
+ *
+ * @param p a predicate with @code is_range_predicate<Pred>::value @endcode
+ */
+template<typename T, typename Pred>
+std::pair<size_t, size_t> sorted_range(const T* data, size_t n, sort_order order, const Pred& p) {
+    auto below = [&p](const T& x) { return range_below(p, x); };
+    auto above = [&p](const T& x) { return range_above(p, x); };
+    auto not_below = [&p](const T& x) { return !range_below(p, x); };
+    auto not_above = [&p](const T& x) { return !range_above(p, x); };
+    const T* first;
+    const T* last;
+    if (order == sort_order::descending) {
+        first = std::partition_point(data, data + n, above);
+        last = std::partition_point(first, data + n, not_below);
+    } else {
+        first = std::partition_point(data, data + n, below);
+        last = std::partition_point(first, data + n, not_above);
+    }
+    return {static_cast<size_t>(first - data), static_cast<size_t>(last - data)};
+}
+/** @brief evaluate a predicate into mask words, skipping blocks the zone map rules out or fully accepts
+ *
+ * @param data first value of the column
+ *
+ * @param first first row to evaluate, a multiple of 64
+ *
+ * @param n number of rows
+ *
+ * @param p a built-in predicate or any functor, zone maps are only consulted for built-in predicates
+ *
+ * @param zones the column statistics, may be nullptr
+ *
+ * @param out destination words for rows [first, first + n)
+ */
+template<typename T, typename Pred>
+void evaluate_predicate_with_zones(const T* data, size_t first, size_t n, const Pred& p,
+                                   const zone_map<T>* zones, selection_mask::word_type* out) {
+    constexpr size_t word_bits = selection_mask::word_bits;
+    if constexpr (std::is_arithmetic_v<T> && is_column_predicate_v<Pred>) {
+        while (zones && n) {
+            size_t len = std::min(n, (first / zone_map_block_rows + 1) * zone_map_block_rows - first);
+            zone_match z = zones->test(first / zone_map_block_rows, p);
+            size_t words = (len + word_bits - 1) / word_bits;
+            if (z == zone_match::some) {
+                evaluate_predicate(data + first, len, p, out);
+            } else {
+                std::fill(out, out + words, z == zone_match::all ? ~selection_mask::word_type(0) : 0);
+                if (z == zone_match::all && len % word_bits)
+                    out[words - 1] = (selection_mask::word_type(1) << (len % word_bits)) - 1;
+            }
+            first += len;
+            n -= len;
+            out += words;
+        }
+    }
+    if (n) evaluate_predicate(data + first, n, p, out);
+}
+/** @brief kinds of secondary index, @code hash @endcode answers equality and @code in @endcode,
+ * @code sorted @endcode also answers range predicates, @code bitmap @endcode keeps one compressed bitmap
+ * per distinct value and suits columns with few distinct values
+ */
+enum class index_kind { hash, sorted, bitmap };
+/** @brief column_index maps values of one column to the rows holding them
+ *
+ * Rows are stored grouped by key, ascending within a key, so a lookup returns a contiguous slice. Rows
+ * holding NaN are left out as they match no built-in predicate.
+ *
+ * @tparam T the column type, @code std::hash<T> @endcode is required for hash indexes
+ */
+template<typename T>
+class column_index {
+public:
+    column_index(index_kind kind = index_kind::sorted): kind(kind) {}
+    /** @brief rebuild the index from the column data
+    *
+    * @param data first value of the column
+    *
+    * @param n number of values
+    *
+    * @param col_version version of the column the index is built from
+    */
+    void build(const T* data, size_t n, size_t col_version) {
+        rows.clear();
+        keys.clear();
+        buckets.clear();
+        // NaN matches no built-in predicate, never equals itself as a key and has no place in the order
+        auto indexed = [data](size_t i) {
+            if constexpr (std::is_floating_point_v<T>) return !std::isnan(data[i]);
+            else return true;
+        };
+        if (kind == index_kind::sorted) {
+            rows.reserve(n);
+            for (size_t i = 0; i < n; i++)
+                if (indexed(i)) rows.push_back(static_cast<row_id_t>(i));
+            std::stable_sort(rows.begin(), rows.end(), [data](row_id_t l, row_id_t r) { return data[l] < data[r]; });
+            keys.resize(rows.size());
+            for (size_t i = 0; i < rows.size(); i++) keys[i] = data[rows[i]];
+        } else {
+            // counting pass, then every key gets a slice of rows
+            size_t m = 0;
+            for (size_t i = 0; i < n; i++) {
+                if (!indexed(i)) continue;
+                ++buckets[data[i]].second;
+                ++m;
+            }
+            size_t offset = 0;
+            for (auto& b: buckets) {
+                b.second.first = offset;
+                offset += b.second.second;
+                b.second.second = b.second.first;
+            }
+            rows.resize(m);
+            for (size_t i = 0; i < n; i++)
+                if (indexed(i)) rows[buckets[data[i]].second++] = static_cast<row_id_t>(i);
+        }
+        size = n;
+        version = col_version;
+        valid = true;
+    }
+    /** @brief rows holding exactly @code key @endcode, ascending
+    */
+    std::pair<const row_id_t*, const row_id_t*> equal_rows(const T& key) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(key)) return {nullptr, nullptr};
+        }
+        if (kind == index_kind::sorted) {
+            auto r = std::equal_range(keys.begin(), keys.end(), key);
+            return {rows.data() + (r.first - keys.begin()), rows.data() + (r.second - keys.begin())};
+        }
+        auto iter = buckets.find(key);
+        if (iter == buckets.end()) return {nullptr, nullptr};
+        return {rows.data() + iter->second.first, rows.data() + iter->second.second};
+    }
+    /** @brief number of rows holding @code key @endcode
+    */
+    size_t count(const T& key) const {
+        auto r = equal_rows(key);
+        return r.second - r.first;
+    }
+    /** @brief whether the index can answer a built-in predicate
+    */
+    template<typename Pred>
+    bool supports(const Pred&) const {
+        if constexpr (is_equality_predicate<Pred>::value) return true;
+        else return kind == index_kind::sorted && is_column_predicate_v<Pred>;
+    }
+    /** @brief rows satisfying a supported built-in predicate, ascending
+    */
+    template<typename Pred>
+    std::vector<row_id_t> lookup(const Pred& p) const {
+        std::vector<row_id_t> ans;
+        if constexpr (is_equality_predicate<Pred>::value) {
+            append_equal(p, ans);
+        } else if constexpr (is_column_predicate_v<Pred>) {
+            auto r = key_range(p);
+            ans.assign(rows.begin() + r.first, rows.begin() + r.second);
+        }
+        std::sort(ans.begin(), ans.end());
+        return ans;
+    }
+    index_kind kind;
+    size_t size = 0;
+    size_t version = 0;
+    bool valid = false;
+private:
+    template<typename Pred>
+    struct is_equality_predicate: std::false_type {};
+    template<typename U>
+    struct is_equality_predicate<equal_to<U>>: std::true_type {};
+    template<typename U>
+    struct is_equality_predicate<in_values<U>>: std::true_type {};
+    template<typename U>
+    void append_equal(const equal_to<U>& p, std::vector<row_id_t>& ans) const {
+        auto r = equal_rows(p.value);
+        ans.insert(ans.end(), r.first, r.second);
+    }
+    template<typename U>
+    void append_equal(const in_values<U>& p, std::vector<row_id_t>& ans) const {
+        for (const auto& v: p.values) {
+            auto r = equal_rows(v);
+            ans.insert(ans.end(), r.first, r.second);
+        }
+    }
+    template<typename U>
+    std::pair<size_t, size_t> key_range(const less_than<U>& p) const {
+        return {0, std::lower_bound(keys.begin(), keys.end(), p.value) - keys.begin()};
+    }
+    template<typename U>
+    std::pair<size_t, size_t> key_range(const less_equal<U>& p) const {
+        return {0, std::upper_bound(keys.begin(), keys.end(), p.value) - keys.begin()};
+    }
+    template<typename U>
+    std::pair<size_t, size_t> key_range(const greater_than<U>& p) const {
+        return {std::upper_bound(keys.begin(), keys.end(), p.value) - keys.begin(), keys.size()};
+    }
+    template<typename U>
+    std::pair<size_t, size_t> key_range(const greater_equal<U>& p) const {
+        return {std::lower_bound(keys.begin(), keys.end(), p.value) - keys.begin(), keys.size()};
+    }
+    template<typename U>
+    std::pair<size_t, size_t> key_range(const between_values<U>& p) const {
+        size_t first = std::lower_bound(keys.begin(), keys.end(), p.low) - keys.begin();
+        size_t last = std::upper_bound(keys.begin(), keys.end(), p.high) - keys.begin();
+        return {first, std::max(first, last)};
+    }
+    std::vector<row_id_t> rows;
+    /* sorted kind: keys[i] is the value of rows[i] */
+    std::vector<T> keys;
+    /* hash kind: key -> [first, last) slice of rows */
+    std::unordered_map<T, std::pair<size_t, size_t>> buckets;
+};
+/** @brief bitmap_index keeps one roaring_bitmap of rows per distinct value of a column
+ *
+ * Conditions on several bitmap-indexed columns are answered by intersecting and uniting bitmaps,
+ * and counted from their cardinalities, without reading the column data.
+ *
+ * @tparam T the column type, it must be ordered by @code operator< @endcode
+ */
+template<typename T>
+class bitmap_index {
+public:
+    /** @brief rebuild the bitmaps from the column data
+    *
+    * @param data first value of the column
+    *
+    * @param n number of values
+    *
+    * @param col_version version of the column the index is built from
+    */
+    void build(const T* data, size_t n, size_t col_version) {
+        bitmaps.clear();
+        auto last = bitmaps.end();
+        for (size_t i = 0; i < n; i++) {
+            if constexpr (std::is_floating_point_v<T>) {
+                // NaN matches no built-in predicate and can't be a map key
+                if (std::isnan(data[i])) continue;
+            }
+            if (last == bitmaps.end() || !(last->first == data[i]))
+                last = bitmaps.try_emplace(data[i]).first;
+            last->second.add(i);
+        }
+        size = n;
+        version = col_version;
+        valid = true;
+    }
+    /** @brief number of distinct values
+    */
+    size_t distinct() const { return bitmaps.size(); }
+    /** @brief rows holding exactly @code key @endcode, nullptr if there are none
+    */
+    const roaring_bitmap* equal_rows(const T& key) const {
+        auto iter = bitmaps.find(key);
+        return iter == bitmaps.end() ? nullptr : &iter->second;
+    }
+    /** @brief rows satisfying a built-in predicate, the union of the bitmaps of every matching value
+    */
+    template<typename U>
+    roaring_bitmap lookup(const equal_to<U>& p) const {
+        const roaring_bitmap* rows = equal_rows(p.value);
+        return rows ? *rows : roaring_bitmap();
+    }
+    template<typename U>
+    roaring_bitmap lookup(const in_values<U>& p) const {
+        roaring_bitmap ans;
+        for (const auto& v: p.values) {
+            if (const roaring_bitmap* rows = equal_rows(v)) ans |= *rows;
+        }
+        return ans;
+    }
+    template<typename Pred, typename = std::enable_if_t<is_column_predicate_v<Pred>>>
+    roaring_bitmap lookup(const Pred& p) const {
+        roaring_bitmap ans;
+        for (const auto& b: bitmaps) {
+            if (p(b.first)) ans |= b.second;
+        }
+        return ans;
+    }
+    size_t size = 0;
+    size_t version = 0;
+    bool valid = false;
+private:
+    std::map<T, roaring_bitmap> bitmaps;
+};
+}}}
+
+#endif
@@ -0,0 +1,951 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_JOIN_
+#define _BOOST_UBLAS_DATA_FRAME_JOIN_
+#include "data_frame_selection.hpp"
+#include "data_frame_index.hpp"
+#include "data_frame_sort.hpp"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief kinds of join, outer joins keep the unmatched rows of one or both sides
+ */
+enum class join_kind { inner, left, right, full };
+/** @brief row id standing for the missing side of an unmatched row in an outer join
+ */
+constexpr row_id_t null_row = -1;
+/** @brief the result of a join as pairs of rows, @code left[i] @endcode is joined with @code right[i] @endcode
+ */
+struct join_pairs {
+    size_t size() const { return left.size(); }
+    std::vector<row_id_t> left;
+    std::vector<row_id_t> right;
+};
+namespace detail {
+/* finalizer of MurmurHash3, spreads every input bit over the whole word */
+inline std::uint64_t mix_hash(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+/* equality of deduplicated values, NaN equals NaN so it's dropped like any repeated value */
+template<typename T>
+bool same_value(const T& a, const T& b) {
+    if constexpr (std::is_floating_point_v<T>) {
+        if (!(a == a)) return !(b == b);
+    }
+    return a == b;
+}
+/* hash of a join key, -0.0 and 0.0 hash the same as they compare equal, and so do all NaNs */
+template<typename T>
+std::uint64_t hash_key(const T& v) {
+    if constexpr (std::is_integral_v<T>) {
+        return mix_hash(static_cast<std::uint64_t>(v));
+    } else if constexpr (std::is_floating_point_v<T> && sizeof(T) <= sizeof(std::uint64_t)) {
+        std::uint64_t bits = 0;
+        T x = v == 0 ? T(0) : (v == v ? v : std::numeric_limits<T>::quiet_NaN());
+        std::memcpy(&bits, &x, sizeof(T));
+        return mix_hash(bits);
+    } else {
+        return mix_hash(std::hash<T>{}(v));
+    }
+}
+}
+/** @brief join_hash_table is an open-addressing hash table grouping the rows of the build side of a join
+ * by key
+ *
+ * Slots hold the key hash and a group number in two flat arrays and are probed linearly. The rows of
+ * every group are stored contiguously and ascending in one array, so the table is a few large blocks
+ * whatever the number of keys. Keys themselves aren't copied, equality is checked by a functor on rows.
+ * A row whose key doesn't equal itself, i.e. holds NaN, can never match and belongs to no group, so it
+ * doesn't open a group of its own on a shared probe chain.
+ */
+class join_hash_table {
+public:
+    /** @brief build the table over rows [0, n) of the build side
+    *
+    * @tparam Equal functor telling whether two build rows have the same key
+    *
+    * @param n number of build rows
+    *
+    * @param hashes the key hash of every build row
+    *
+    * @param equal the key equality
+    */
+    template<typename Equal>
+    void build(size_t n, const std::uint64_t* hashes, Equal equal) {
+        size_t capacity = 16;
+        while (capacity < 2 * n) capacity *= 2;
+        mask = capacity - 1;
+        slot_hash.assign(capacity, 0);
+        slot_group.assign(capacity, null_row);
+        row_group.assign(n, null_row);
+        std::vector<row_id_t> first_row;
+        std::vector<size_t> counts;
+        size_t grouped = 0;
+        for (size_t i = 0; i < n; i++) {
+            std::uint64_t h = hashes[i];
+            for (size_t pos = h & mask;; pos = (pos + 1) & mask) {
+                row_id_t g = slot_group[pos];
+                if (g == null_row) {
+                    if (!equal(static_cast<row_id_t>(i), static_cast<row_id_t>(i))) break;
+                    g = static_cast<row_id_t>(counts.size());
+                    slot_group[pos] = g;
+                    slot_hash[pos] = h;
+                    first_row.push_back(static_cast<row_id_t>(i));
+                    counts.push_back(0);
+                } else if (slot_hash[pos] != h || !equal(first_row[g], static_cast<row_id_t>(i))) {
+                    continue;
+                }
+                ++counts[g];
+                ++grouped;
+                row_group[i] = g;
+                break;
+            }
+        }
+        group_first.assign(counts.size() + 1, 0);
+        for (size_t g = 0; g < counts.size(); g++) group_first[g + 1] = group_first[g] + counts[g];
+        rows.resize(grouped);
+        std::vector<size_t> cursor(group_first.begin(), group_first.end() - 1);
+        for (size_t i = 0; i < n; i++)
+            if (row_group[i] != null_row) rows[cursor[row_group[i]]++] = static_cast<row_id_t>(i);
+    }
+    /** @brief group of the build rows whose key equals a probe key, @code null_row @endcode if there is none
+    *
+    * @tparam Match functor telling whether a build row has the probe key
+    *
+    * @param h hash of the probe key
+    *
+    * @param match the key equality against the probe key
+    */
+    template<typename Match>
+    row_id_t find(std::uint64_t h, Match match) const {
+        for (size_t pos = h & mask;; pos = (pos + 1) & mask) {
+            row_id_t g = slot_group[pos];
+            if (g == null_row) return null_row;
+            if (slot_hash[pos] == h && match(rows[group_first[g]])) return g;
+        }
+    }
+    /** @brief build rows of group @code g @endcode, ascending
+    */
+    std::pair<const row_id_t*, const row_id_t*> group_rows(row_id_t g) const {
+        return {rows.data() + group_first[g], rows.data() + group_first[g + 1]};
+    }
+    /** @brief group of build row @code row @endcode, @code null_row @endcode if its key doesn't equal itself
+    */
+    row_id_t group_of(row_id_t row) const { return row_group[row]; }
+    /** @brief number of distinct keys
+    */
+    size_t groups() const { return group_first.empty() ? 0 : group_first.size() - 1; }
+private:
+    size_t mask = 0;
+    std::vector<std::uint64_t> slot_hash;
+    std::vector<row_id_t> slot_group;
+    std::vector<row_id_t> row_group;
+    std::vector<size_t> group_first;
+    std::vector<row_id_t> rows;
+};
+/** @brief bloom_filter answers whether a key hash may have been inserted, with no false negatives
+ *
+ * Every key sets four bits of one 64-bit word, so a lookup reads a single word. At the default 12 bits per
+ * key about one lookup in a hundred of a missing key passes.
+ */
+class bloom_filter {
+public:
+    /** @brief Build an empty filter sized for a number of keys
+    *
+    * @param keys the number of keys to be inserted
+    *
+    * @param bits_per_key filter bits per key, more bits mean fewer false positives
+    */
+    explicit bloom_filter(size_t keys, size_t bits_per_key = 12) {
+        size_t words = 1;
+        while (words * 64 < keys * bits_per_key) words *= 2;
+        bits.assign(words, 0);
+    }
+    void insert(std::uint64_t h) {
+        bits[word(h)] |= pattern(h);
+    }
+    bool may_contain(std::uint64_t h) const {
+        std::uint64_t p = pattern(h);
+        return (bits[word(h)] & p) == p;
+    }
+private:
+    size_t word(std::uint64_t h) const { return (h >> 32) & (bits.size() - 1); }
+    static std::uint64_t pattern(std::uint64_t h) {
+        return (std::uint64_t(1) << (h & 63)) | (std::uint64_t(1) << ((h >> 6) & 63)) |
+               (std::uint64_t(1) << ((h >> 12) & 63)) | (std::uint64_t(1) << ((h >> 18) & 63));
+    }
+    std::vector<std::uint64_t> bits;
+};
+/** @brief join_key_set holds the distinct keys of one side of a semi or anti join
+ *
+ * A lookup is first checked against a @code bloom_filter @endcode, so most keys without a match are rejected
+ * without probing the hash table. The keys are copied, the set doesn't refer to the column it was built from.
+ *
+ * @tparam T the key type
+ */
+template<typename T>
+class join_key_set {
+public:
+    /** @brief Build the set of the values of a column, NaN is left out as it never matches
+    *
+    * @param data first value of the column
+    *
+    * @param n number of values
+    */
+    join_key_set(const T* data, size_t n) {
+        std::vector<std::uint64_t> hashes(n);
+        for (size_t i = 0; i < n; i++) hashes[i] = detail::hash_key(data[i]);
+        join_hash_table all;
+        all.build(n, hashes.data(), [data](row_id_t a, row_id_t b) { return data[a] == data[b]; });
+        std::vector<std::uint64_t> key_hashes;
+        keys.reserve(all.groups());
+        key_hashes.reserve(all.groups());
+        for (size_t g = 0; g < all.groups(); g++) {
+            row_id_t row = *all.group_rows(static_cast<row_id_t>(g)).first;
+            keys.push_back(data[row]);
+            key_hashes.push_back(hashes[row]);
+        }
+        // the keys are distinct, two of them never compare equal
+        table.build(keys.size(), key_hashes.data(), [](row_id_t a, row_id_t b) { return a == b; });
+        filter = bloom_filter(keys.size());
+        for (auto h: key_hashes) filter.insert(h);
+    }
+    bool contains(const T& v) const {
+        std::uint64_t h = detail::hash_key(v);
+        return filter.may_contain(h) && table.find(h, [this, &v](row_id_t k) { return keys[k] == v; }) != null_row;
+    }
+    /** @brief number of distinct keys
+    */
+    size_t size() const { return keys.size(); }
+private:
+    std::vector<T> keys;
+    join_hash_table table;
+    bloom_filter filter{0};
+};
+/** @brief join key on one column of each side, compared with @code == @endcode so NaN never matches
+ *
+ * @tparam T the key type
+ */
+template<typename T>
+struct column_join_key {
+    column_join_key(const T* l, size_t nl, const T* r, size_t nr): l(l), r(r), nl(nl), nr(nr) {}
+    size_t left_size() const { return nl; }
+    size_t right_size() const { return nr; }
+    std::uint64_t hash_left(row_id_t i) const { return detail::hash_key(l[i]); }
+    std::uint64_t hash_right(row_id_t i) const { return detail::hash_key(r[i]); }
+    bool equal(row_id_t li, row_id_t ri) const { return l[li] == r[ri]; }
+    bool equal_left(row_id_t a, row_id_t b) const { return l[a] == l[b]; }
+    bool equal_right(row_id_t a, row_id_t b) const { return r[a] == r[b]; }
+    const T* l;
+    const T* r;
+    size_t nl;
+    size_t nr;
+};
+/** @brief join key on several columns of each side, compared column by column
+ *
+ * Key columns are added in pairs of the same type, the names may differ between the sides. The hash of a
+ * row is folded column at a time as columns are added, equality visits the columns in order and stops at
+ * the first difference, so no concatenated key is ever built.
+ *
+ * @tparam Types the possible key types, without repetition
+ */
+template<typename... Types>
+class composite_join_key {
+public:
+    /** @brief Build a key without columns over nl left and nr right rows
+    */
+    composite_join_key(size_t nl, size_t nr): lh(nl, 0), rh(nr, 0) {}
+    /** @brief add one key column of each side
+    *
+    * @tparam T the type of both columns
+    *
+    * @param l first value of the left column
+    *
+    * @param r first value of the right column
+    *
+    * @param pool the threads hashing the columns
+    */
+    template<typename T>
+    composite_join_key& add_column(const T* l, const T* r, thread_pool& pool = default_thread_pool()) {
+        static_assert(((std::is_same_v<T, Types>) || ...), "T type doesn't belong to the key types");
+        size_t nl = lh.size(), nr = rh.size();
+        size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, std::max(nl, nr) / parallel_sort_min_rows));
+        pool.parallel_for(tasks, [&](size_t t) {
+            for (size_t i = nl * t / tasks; i < nl * (t + 1) / tasks; i++) lh[i] = detail::mix_hash(lh[i] + detail::hash_key(l[i]));
+            for (size_t i = nr * t / tasks; i < nr * (t + 1) / tasks; i++) rh[i] = detail::mix_hash(rh[i] + detail::hash_key(r[i]));
+        });
+        columns.emplace_back(std::in_place_type<column_pair<T>>, l, r);
+        return *this;
+    }
+    size_t left_size() const { return lh.size(); }
+    size_t right_size() const { return rh.size(); }
+    std::uint64_t hash_left(row_id_t i) const { return lh[i]; }
+    std::uint64_t hash_right(row_id_t i) const { return rh[i]; }
+    bool equal(row_id_t li, row_id_t ri) const {
+        for (const auto& c: columns)
+            if (!std::visit([li, ri](const auto& p) { return p.first[li] == p.second[ri]; }, c)) return false;
+        return true;
+    }
+    bool equal_left(row_id_t a, row_id_t b) const {
+        for (const auto& c: columns)
+            if (!std::visit([a, b](const auto& p) { return p.first[a] == p.first[b]; }, c)) return false;
+        return true;
+    }
+    bool equal_right(row_id_t a, row_id_t b) const {
+        for (const auto& c: columns)
+            if (!std::visit([a, b](const auto& p) { return p.second[a] == p.second[b]; }, c)) return false;
+        return true;
+    }
+    /** @brief like @code equal @endcode, except NaN equals NaN, to deduplicate rows
+    */
+    bool same(row_id_t li, row_id_t ri) const {
+        for (const auto& c: columns)
+            if (!std::visit([li, ri](const auto& p) { return detail::same_value(p.first[li], p.second[ri]); }, c)) return false;
+        return true;
+    }
+    /** @brief like @code equal_left @endcode, except NaN equals NaN
+    */
+    bool same_left(row_id_t a, row_id_t b) const {
+        for (const auto& c: columns)
+            if (!std::visit([a, b](const auto& p) { return detail::same_value(p.first[a], p.first[b]); }, c)) return false;
+        return true;
+    }
+    /** @brief like @code equal_right @endcode, except NaN equals NaN
+    */
+    bool same_right(row_id_t a, row_id_t b) const {
+        for (const auto& c: columns)
+            if (!std::visit([a, b](const auto& p) { return detail::same_value(p.second[a], p.second[b]); }, c)) return false;
+        return true;
+    }
+    /** @brief number of key columns
+    */
+    size_t size() const { return columns.size(); }
+private:
+    template<typename T>
+    using column_pair = std::pair<const T*, const T*>;
+    std::vector<std::variant<column_pair<Types>...>> columns;
+    std::vector<std::uint64_t> lh;
+    std::vector<std::uint64_t> rh;
+};
+/** @brief join two sides with a hash table built on the smaller one
+ *
+ * The result doesn't depend on which side is built on. Pairs come in left row order, the rows of the right
+ * side matching one left row ascending, and an unmatched left row of a left or full join in its place.
+ * Unmatched right rows of a right or full join follow in right row order.
+ *
+ * @tparam Key a join key like @code column_join_key @endcode
+ *
+ * @param key the key columns of both sides
+ *
+ * @param kind which unmatched rows are kept
+ */
+template<typename Key>
+join_pairs hash_join(const Key& key, join_kind kind) {
+    size_t nl = key.left_size(), nr = key.right_size();
+    bool keep_left = kind == join_kind::left || kind == join_kind::full;
+    bool keep_right = kind == join_kind::right || kind == join_kind::full;
+    std::vector<std::uint64_t> lh(nl), rh(nr);
+    for (size_t i = 0; i < nl; i++) lh[i] = key.hash_left(static_cast<row_id_t>(i));
+    for (size_t i = 0; i < nr; i++) rh[i] = key.hash_right(static_cast<row_id_t>(i));
+    join_pairs ans;
+    join_hash_table table;
+    std::vector<char> right_matched(keep_right ? nr : 0, 0);
+    if (nr <= nl) {
+        table.build(nr, rh.data(), [&key](row_id_t a, row_id_t b) { return key.equal_right(a, b); });
+        for (size_t i = 0; i < nl; i++) {
+            row_id_t l = static_cast<row_id_t>(i);
+            // a NaN key matches nothing, it isn't probed
+            row_id_t g = key.equal_left(l, l) ? table.find(lh[i], [&key, l](row_id_t r) { return key.equal(l, r); }) : null_row;
+            if (g == null_row) {
+                if (keep_left) {
+                    ans.left.push_back(l);
+                    ans.right.push_back(null_row);
+                }
+                continue;
+            }
+            auto range = table.group_rows(g);
+            for (auto r = range.first; r != range.second; ++r) {
+                ans.left.push_back(l);
+                ans.right.push_back(*r);
+                if (keep_right) right_matched[*r] = 1;
+            }
+        }
+    } else {
+        // built on the left: count the matches of every left row first, then scatter the pairs
+        // into left row order
+        table.build(nl, lh.data(), [&key](row_id_t a, row_id_t b) { return key.equal_left(a, b); });
+        std::vector<row_id_t> right_group(nr);
+        std::vector<size_t> group_matches(table.groups(), 0);
+        for (size_t j = 0; j < nr; j++) {
+            row_id_t r = static_cast<row_id_t>(j);
+            right_group[j] = key.equal_right(r, r) ? table.find(rh[j], [&key, r](row_id_t l) { return key.equal(l, r); }) : null_row;
+            if (right_group[j] != null_row) ++group_matches[right_group[j]];
+        }
+        // left rows of no group hold NaN and match nothing
+        auto matches = [&](size_t i) {
+            row_id_t g = table.group_of(static_cast<row_id_t>(i));
+            return g == null_row ? size_t(0) : group_matches[g];
+        };
+        std::vector<size_t> cursor(nl + 1, 0);
+        for (size_t i = 0; i < nl; i++) {
+            size_t m = matches(i);
+            cursor[i + 1] = cursor[i] + (m ? m : (keep_left ? 1 : 0));
+        }
+        ans.left.resize(cursor[nl]);
+        ans.right.resize(cursor[nl]);
+        for (size_t i = 0; i < nl; i++) {
+            if (cursor[i + 1] == cursor[i] || matches(i)) continue;
+            ans.left[cursor[i]] = static_cast<row_id_t>(i);
+            ans.right[cursor[i]] = null_row;
+        }
+        for (size_t j = 0; j < nr; j++) {
+            if (right_group[j] == null_row) continue;
+            if (keep_right) right_matched[j] = 1;
+            auto range = table.group_rows(right_group[j]);
+            for (auto l = range.first; l != range.second; ++l) {
+                size_t pos = cursor[*l]++;
+                ans.left[pos] = *l;
+                ans.right[pos] = static_cast<row_id_t>(j);
+            }
+        }
+    }
+    if (keep_right) {
+        for (size_t j = 0; j < nr; j++) {
+            if (right_matched[j]) continue;
+            ans.left.push_back(null_row);
+            ans.right.push_back(static_cast<row_id_t>(j));
+        }
+    }
+    return ans;
+}
+/** @brief join two key columns through an existing index of one of them instead of building a hash table,
+ * the pairs come in the order of @code hash_join @endcode
+ *
+ * @tparam T the key type
+ *
+ * @param l first key of the left side
+ *
+ * @param nl number of left rows
+ *
+ * @param r first key of the right side
+ *
+ * @param nr number of right rows
+ *
+ * @param index an index of the left or the right keys, NaN rows left out
+ *
+ * @param index_right whether @code index @endcode indexes the right keys
+ *
+ * @param kind which unmatched rows are kept
+ */
+template<typename T>
+join_pairs index_join(const T* l, size_t nl, const T* r, size_t nr, const column_index<T>& index, bool index_right,
+    join_kind kind) {
+    bool keep_left = kind == join_kind::left || kind == join_kind::full;
+    bool keep_right = kind == join_kind::right || kind == join_kind::full;
+    join_pairs ans;
+    std::vector<char> right_matched(keep_right ? nr : 0, 0);
+    if (index_right) {
+        for (size_t i = 0; i < nl; i++) {
+            auto range = index.equal_rows(l[i]);
+            if (range.first == range.second && keep_left) {
+                ans.left.push_back(static_cast<row_id_t>(i));
+                ans.right.push_back(null_row);
+            }
+            for (auto j = range.first; j != range.second; ++j) {
+                ans.left.push_back(static_cast<row_id_t>(i));
+                ans.right.push_back(*j);
+                if (keep_right) right_matched[*j] = 1;
+            }
+        }
+    } else {
+        // count the matches of every left row first, then scatter the pairs into left row order
+        std::vector<size_t> matches(nl, 0);
+        for (size_t j = 0; j < nr; j++) {
+            auto range = index.equal_rows(r[j]);
+            for (auto i = range.first; i != range.second; ++i) ++matches[*i];
+        }
+        std::vector<size_t> cursor(nl + 1, 0);
+        for (size_t i = 0; i < nl; i++) cursor[i + 1] = cursor[i] + (matches[i] ? matches[i] : (keep_left ? 1 : 0));
+        ans.left.resize(cursor[nl]);
+        ans.right.resize(cursor[nl]);
+        for (size_t i = 0; i < nl; i++) {
+            if (matches[i] || !keep_left) continue;
+            ans.left[cursor[i]] = static_cast<row_id_t>(i);
+            ans.right[cursor[i]] = null_row;
+        }
+        for (size_t j = 0; j < nr; j++) {
+            auto range = index.equal_rows(r[j]);
+            if (keep_right && range.first != range.second) right_matched[j] = 1;
+            for (auto i = range.first; i != range.second; ++i) {
+                size_t pos = cursor[*i]++;
+                ans.left[pos] = *i;
+                ans.right[pos] = static_cast<row_id_t>(j);
+            }
+        }
+    }
+    if (keep_right) {
+        for (size_t j = 0; j < nr; j++) {
+            if (right_matched[j]) continue;
+            ans.left.push_back(null_row);
+            ans.right.push_back(static_cast<row_id_t>(j));
+        }
+    }
+    return ans;
+}
+namespace detail {
+/* a join key restricted to one radix partition of each side, rows are numbered within the partition and
+ * hashes come from the arrays computed once for the whole input */
+template<typename Key>
+struct partition_join_key {
+    size_t left_size() const { return nl; }
+    size_t right_size() const { return nr; }
+    std::uint64_t hash_left(row_id_t i) const { return lh[lrows[i]]; }
+    std::uint64_t hash_right(row_id_t i) const { return rh[rrows[i]]; }
+    bool equal(row_id_t a, row_id_t b) const { return key.equal(lrows[a], rrows[b]); }
+    bool equal_left(row_id_t a, row_id_t b) const { return key.equal_left(lrows[a], lrows[b]); }
+    bool equal_right(row_id_t a, row_id_t b) const { return key.equal_right(rrows[a], rrows[b]); }
+    const Key& key;
+    const std::uint64_t* lh;
+    const std::uint64_t* rh;
+    const row_id_t* lrows;
+    const row_id_t* rrows;
+    size_t nl;
+    size_t nr;
+};
+/* scatter rows [0, n) into 2^bits partitions by the top bits of their hash, partition p taking
+ * rows[bounds[p], bounds[p + 1]) ascending */
+inline void radix_partition(const std::uint64_t* hashes, size_t n, unsigned bits,
+    std::vector<row_id_t>& rows, std::vector<size_t>& bounds, thread_pool& pool) {
+    size_t parts = size_t(1) << bits;
+    unsigned shift = 64 - bits;
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+    std::vector<size_t> counts(tasks * parts, 0);
+    pool.parallel_for(tasks, [&](size_t t) {
+        size_t* count = &counts[t * parts];
+        for (size_t i = n * t / tasks; i < n * (t + 1) / tasks; i++) ++count[hashes[i] >> shift];
+    });
+    // partition-major offsets, the task order inside a partition keeps its rows ascending
+    bounds.assign(parts + 1, 0);
+    size_t sum = 0;
+    for (size_t p = 0; p < parts; p++) {
+        bounds[p] = sum;
+        for (size_t t = 0; t < tasks; t++) {
+            size_t c = counts[t * parts + p];
+            counts[t * parts + p] = sum;
+            sum += c;
+        }
+    }
+    bounds[parts] = sum;
+    rows.resize(n);
+    pool.parallel_for(tasks, [&](size_t t) {
+        size_t* cursor = &counts[t * parts];
+        for (size_t i = n * t / tasks; i < n * (t + 1) / tasks; i++)
+            rows[cursor[hashes[i] >> shift]++] = static_cast<row_id_t>(i);
+    });
+}
+}
+/** @brief number of build rows a partition of @code parallel_hash_join @endcode aims at, so that its hash
+ * table stays in cache
+ */
+constexpr size_t join_partition_rows = 1 << 15;
+/** @brief hash join on a thread pool by radix partitioning both sides on the key hash
+ *
+ * Hashes are computed and both sides scattered into partitions in parallel, then every pair of partitions
+ * is joined on its own, the pool handing partitions to whichever thread is free. Every task writes to its
+ * own output, which is sized first and then scattered into disjoint ranges of the result, so the threads
+ * never share a lock. The result is the same as @code hash_join @endcode, small inputs are simply given to
+ * it.
+ *
+ * @tparam Key a join key like @code column_join_key @endcode
+ *
+ * @param key the key columns of both sides
+ *
+ * @param kind which unmatched rows are kept
+ *
+ * @param pool the threads to run on
+ */
+template<typename Key>
+join_pairs parallel_hash_join(const Key& key, join_kind kind, thread_pool& pool = default_thread_pool()) {
+    size_t nl = key.left_size(), nr = key.right_size();
+    size_t build = std::min(nl, nr);
+    if (pool.size() < 2 || std::max(nl, nr) < parallel_sort_min_rows) return hash_join(key, kind);
+    unsigned bits = 1;
+    while (bits < 12 && ((build >> bits) > join_partition_rows || (size_t(1) << bits) < pool.size() * 4)) ++bits;
+    bool keep_right = kind == join_kind::right || kind == join_kind::full;
+    std::vector<std::uint64_t> lh(nl), rh(nr);
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, std::max(nl, nr) / parallel_sort_min_rows));
+    pool.parallel_for(tasks, [&](size_t t) {
+        for (size_t i = nl * t / tasks; i < nl * (t + 1) / tasks; i++) lh[i] = key.hash_left(static_cast<row_id_t>(i));
+        for (size_t i = nr * t / tasks; i < nr * (t + 1) / tasks; i++) rh[i] = key.hash_right(static_cast<row_id_t>(i));
+    });
+    std::vector<row_id_t> lrows, rrows;
+    std::vector<size_t> lbounds, rbounds;
+    detail::radix_partition(lh.data(), nl, bits, lrows, lbounds, pool);
+    detail::radix_partition(rh.data(), nr, bits, rrows, rbounds, pool);
+    // every row belongs to one partition, so the per-row counts and flags are written by one task each
+    size_t parts = size_t(1) << bits;
+    std::vector<join_pairs> part_pairs(parts);
+    std::vector<size_t> cursor(nl + 1, 0);
+    std::vector<char> right_matched(keep_right ? nr : 0, 0);
+    pool.parallel_for(parts, [&](size_t p) {
+        detail::partition_join_key<Key> part{key, lh.data(), rh.data(),
+            lrows.data() + lbounds[p], rrows.data() + rbounds[p], lbounds[p + 1] - lbounds[p], rbounds[p + 1] - rbounds[p]};
+        join_pairs& pairs = part_pairs[p];
+        pairs = hash_join(part, kind);
+        for (size_t i = 0; i < pairs.size(); i++) {
+            if (pairs.left[i] == null_row) {
+                pairs.left.resize(i);
+                pairs.right.resize(i);
+                break;
+            }
+            pairs.left[i] = part.lrows[pairs.left[i]];
+            if (pairs.right[i] != null_row) {
+                pairs.right[i] = part.rrows[pairs.right[i]];
+                if (keep_right) right_matched[pairs.right[i]] = 1;
+            }
+            ++cursor[pairs.left[i] + 1];
+        }
+    });
+    for (size_t i = 0; i < nl; i++) cursor[i + 1] += cursor[i];
+    size_t matched = cursor[nl];
+    std::vector<size_t> right_only(tasks + 1, 0);
+    if (keep_right) {
+        pool.parallel_for(tasks, [&](size_t t) {
+            for (size_t j = nr * t / tasks; j < nr * (t + 1) / tasks; j++) right_only[t + 1] += !right_matched[j];
+        });
+        for (size_t t = 0; t < tasks; t++) right_only[t + 1] += right_only[t];
+    }
+    join_pairs ans;
+    ans.left.resize(matched + right_only[tasks]);
+    ans.right.resize(matched + right_only[tasks]);
+    // the pairs of one left row are contiguous within its partition and already in order
+    pool.parallel_for(parts, [&](size_t p) {
+        const join_pairs& pairs = part_pairs[p];
+        for (size_t i = 0; i < pairs.size(); i++) {
+            size_t pos = cursor[pairs.left[i]]++;
+            ans.left[pos] = pairs.left[i];
+            ans.right[pos] = pairs.right[i];
+        }
+    });
+    if (keep_right) {
+        pool.parallel_for(tasks, [&](size_t t) {
+            size_t pos = matched + right_only[t];
+            for (size_t j = nr * t / tasks; j < nr * (t + 1) / tasks; j++) {
+                if (right_matched[j]) continue;
+                ans.left[pos] = null_row;
+                ans.right[pos++] = static_cast<row_id_t>(j);
+            }
+        });
+    }
+    return ans;
+}
+/** @brief which of several equal rows @code distinct_rows @endcode keeps
+ */
+enum class keep_duplicate { first, last };
+/** @brief the rows of the left side of a key without duplicates, ascending
+ *
+ * Rows are radix partitioned on their hash and every partition is deduplicated with its own hash table on the
+ * pool. Equal rows always land in the same partition, where they stay in row order, so the rows kept don't
+ * depend on the number of threads. Rows are compared with @code same_left @endcode, so NaN equals NaN.
+ *
+ * @tparam Key a key like @code composite_join_key @endcode, only its left side is used
+ *
+ * @param key the compared columns
+ *
+ * @param keep which of several equal rows is kept
+ *
+ * @param pool the threads to run on
+ */
+template<typename Key>
+std::vector<row_id_t> distinct_rows(const Key& key, keep_duplicate keep, thread_pool& pool = default_thread_pool()) {
+    size_t n = key.left_size();
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+    std::vector<std::uint64_t> hashes(n);
+    pool.parallel_for(tasks, [&](size_t t) {
+        for (size_t i = n * t / tasks; i < n * (t + 1) / tasks; i++) hashes[i] = key.hash_left(static_cast<row_id_t>(i));
+    });
+    unsigned bits = 0;
+    if (pool.size() > 1 && n >= parallel_sort_min_rows) {
+        bits = 1;
+        while (bits < 12 && ((n >> bits) > join_partition_rows || (size_t(1) << bits) < pool.size() * 4)) ++bits;
+    }
+    std::vector<row_id_t> rows;
+    std::vector<size_t> bounds{0, n};
+    if (bits) {
+        detail::radix_partition(hashes.data(), n, bits, rows, bounds, pool);
+    } else {
+        rows.resize(n);
+        for (size_t i = 0; i < n; i++) rows[i] = static_cast<row_id_t>(i);
+    }
+    // every row belongs to one partition, so each flag is written by one task
+    std::vector<char> kept(n, 0);
+    pool.parallel_for(bounds.size() - 1, [&](size_t p) {
+        const row_id_t* part = rows.data() + bounds[p];
+        size_t len = bounds[p + 1] - bounds[p];
+        std::vector<std::uint64_t> part_hashes(len);
+        for (size_t i = 0; i < len; i++) part_hashes[i] = hashes[part[i]];
+        join_hash_table table;
+        table.build(len, part_hashes.data(), [&key, part](row_id_t a, row_id_t b) { return key.same_left(part[a], part[b]); });
+        for (size_t g = 0; g < table.groups(); g++) {
+            auto range = table.group_rows(static_cast<row_id_t>(g));
+            kept[part[keep == keep_duplicate::first ? *range.first : *(range.second - 1)]] = 1;
+        }
+    });
+    std::vector<row_id_t> ans;
+    for (size_t i = 0; i < n; i++)
+        if (kept[i]) ans.push_back(static_cast<row_id_t>(i));
+    return ans;
+}
+/** @brief join two key columns sorted in the same direction by merging them with two cursors
+ *
+ * The result is the same as @code hash_join @endcode, which for sorted columns is key order. Apart from the
+ * output nothing is allocated.
+ *
+ * @tparam T the key type
+ *
+ * @param l first key of the left side
+ *
+ * @param nl number of left rows
+ *
+ * @param r first key of the right side
+ *
+ * @param nr number of right rows
+ *
+ * @param order the order of both columns, ascending or descending
+ *
+ * @param kind which unmatched rows are kept
+ */
+template<typename T>
+join_pairs merge_join(const T* l, size_t nl, const T* r, size_t nr, sort_order order, join_kind kind) {
+    bool keep_left = kind == join_kind::left || kind == join_kind::full;
+    bool keep_right = kind == join_kind::right || kind == join_kind::full;
+    auto before = [order](const T& a, const T& b) { return order == sort_order::descending ? b < a : a < b; };
+    join_pairs ans;
+    // unmatched right rows go last, they are collected on the way
+    std::vector<row_id_t> right_only;
+    size_t i = 0, j = 0;
+    while (i < nl) {
+        for (; j < nr && before(r[j], l[i]); j++)
+            if (keep_right) right_only.push_back(static_cast<row_id_t>(j));
+        size_t j_end = j;
+        while (j_end < nr && !before(l[i], r[j_end])) ++j_end;
+        size_t i_end = i + 1;
+        while (i_end < nl && !before(l[i], l[i_end])) ++i_end;
+        for (; i < i_end; i++) {
+            if (j == j_end) {
+                if (keep_left) {
+                    ans.left.push_back(static_cast<row_id_t>(i));
+                    ans.right.push_back(null_row);
+                }
+                continue;
+            }
+            for (size_t k = j; k < j_end; k++) {
+                ans.left.push_back(static_cast<row_id_t>(i));
+                ans.right.push_back(static_cast<row_id_t>(k));
+            }
+        }
+        j = j_end;
+    }
+    for (; j < nr && keep_right; j++) right_only.push_back(static_cast<row_id_t>(j));
+    ans.left.insert(ans.left.end(), right_only.size(), null_row);
+    ans.right.insert(ans.right.end(), right_only.begin(), right_only.end());
+    return ans;
+}
+/** @brief which right row an as-of join picks, the last one at or before the left key or the first one at or
+ * after it
+ */
+enum class asof_direction { backward, forward };
+/** @brief settings of an as-of join of data_frames
+ *
+ * @tparam T the key type
+ */
+template<typename T>
+struct asof_options {
+    asof_direction direction = asof_direction::backward;
+    /* column both sides must match exactly, e.g. the symbol, none if empty */
+    std::string by;
+    /* the largest distance between matched keys, unbounded if empty */
+    std::optional<T> tolerance;
+};
+/** @brief number the distinct keys of the right side of a join and give every row of both sides the number
+ * of its key, @code null_row @endcode for a left key missing on the right
+ *
+ * @tparam Key a join key like @code column_join_key @endcode
+ *
+ * @param key the key columns of both sides
+ *
+ * @param left_group receives the key number of every left row
+ *
+ * @param right_group receives the key number of every right row
+ *
+ * @return the number of distinct right keys
+ */
+template<typename Key>
+size_t join_groups(const Key& key, std::vector<row_id_t>& left_group, std::vector<row_id_t>& right_group) {
+    size_t nl = key.left_size(), nr = key.right_size();
+    std::vector<std::uint64_t> rh(nr);
+    for (size_t j = 0; j < nr; j++) rh[j] = key.hash_right(static_cast<row_id_t>(j));
+    join_hash_table table;
+    table.build(nr, rh.data(), [&key](row_id_t a, row_id_t b) { return key.equal_right(a, b); });
+    right_group.resize(nr);
+    for (size_t j = 0; j < nr; j++) right_group[j] = table.group_of(static_cast<row_id_t>(j));
+    left_group.resize(nl);
+    for (size_t i = 0; i < nl; i++) {
+        row_id_t l = static_cast<row_id_t>(i);
+        left_group[i] = key.equal_left(l, l) ? table.find(key.hash_left(l), [&key, l](row_id_t r) { return key.equal(l, r); }) : null_row;
+    }
+    return table.groups();
+}
+/** @brief as-of join of two ascending key columns in one merge pass, every left row gets the nearest right
+ * row in the given direction among the rows of its group
+ *
+ * With groups the last right row seen of every group is remembered, so the pass stays linear. Of several
+ * right rows with the same key, a backward join picks the last one and a forward join the first one.
+ *
+ * @tparam T an arithmetic key type
+ *
+ * @param l first key of the left side, ascending
+ *
+ * @param nl number of left rows
+ *
+ * @param r first key of the right side, ascending
+ *
+ * @param nr number of right rows
+ *
+ * @param left_group the group of every left row, nullptr when there are no groups
+ *
+ * @param right_group the group of every right row, nullptr when there are no groups
+ *
+ * @param groups number of groups
+ *
+ * @param direction whether the right key is at or before, or at or after the left key
+ *
+ * @param tolerance the largest distance between matched keys, unbounded if empty
+ *
+ * @return the right row matched with every left row, @code null_row @endcode if there is none
+ */
+template<typename T>
+std::vector<row_id_t> asof_merge(const T* l, size_t nl, const T* r, size_t nr,
+    const row_id_t* left_group, const row_id_t* right_group, size_t groups,
+    asof_direction direction, std::optional<T> tolerance = std::nullopt) {
+    static_assert(std::is_arithmetic_v<T>, "as-of joins need an arithmetic key");
+    std::vector<row_id_t> ans(nl, null_row);
+    std::vector<row_id_t> seen(left_group ? groups : 1, null_row);
+    auto match = [&](size_t i) {
+        // NaN compares false with everything, it never matches
+        if (!(l[i] == l[i])) return;
+        row_id_t g = left_group ? left_group[i] : 0;
+        if (g == null_row || seen[g] == null_row) return;
+        T distance = direction == asof_direction::backward ? l[i] - r[seen[g]] : r[seen[g]] - l[i];
+        if (tolerance && distance > *tolerance) return;
+        ans[i] = seen[g];
+    };
+    // a right row of no group has a NaN in the by column and is never matched
+    auto remember = [&](size_t j) {
+        row_id_t g = right_group ? right_group[j] : 0;
+        if (g != null_row) seen[g] = static_cast<row_id_t>(j);
+    };
+    if (direction == asof_direction::backward) {
+        size_t j = 0;
+        for (size_t i = 0; i < nl; i++) {
+            for (; j < nr && r[j] <= l[i]; j++) remember(j);
+            match(i);
+        }
+    } else {
+        // NaN sorts last and would stop the scan, start below it
+        size_t j = nr;
+        while (j > 0 && !(r[j - 1] == r[j - 1])) --j;
+        for (size_t i = nl; i-- > 0;) {
+            for (; j > 0 && r[j - 1] >= l[i]; j--) remember(j - 1);
+            match(i);
+        }
+    }
+    return ans;
+}
+/** @brief band join of two ascending key columns, pairing rows whose keys are at most delta apart, with a
+ * window over the right side sliding along the left side
+ *
+ * The pairs come in the order of @code hash_join @endcode. It runs in time linear in the input and output.
+ *
+ * @tparam T an arithmetic key type
+ *
+ * @param l first key of the left side, ascending
+ *
+ * @param nl number of left rows
+ *
+ * @param r first key of the right side, ascending
+ *
+ * @param nr number of right rows
+ *
+ * @param delta the largest distance between matched keys
+ *
+ * @param kind which unmatched rows are kept
+ */
+template<typename T>
+join_pairs band_merge(const T* l, size_t nl, const T* r, size_t nr, T delta, join_kind kind) {
+    static_assert(std::is_arithmetic_v<T>, "band joins need an arithmetic key");
+    bool keep_left = kind == join_kind::left || kind == join_kind::full;
+    bool keep_right = kind == join_kind::right || kind == join_kind::full;
+    std::vector<char> right_matched(keep_right ? nr : 0, 0);
+    join_pairs ans;
+    size_t first = 0, last = 0;
+    for (size_t i = 0; i < nl; i++) {
+        if (l[i] == l[i]) {
+            while (first < nr && r[first] < l[i] && l[i] - r[first] > delta) ++first;
+            last = std::max(first, last);
+            while (last < nr && (r[last] <= l[i] || r[last] - l[i] <= delta)) ++last;
+        }
+        if (!(l[i] == l[i]) || first == last) {
+            if (keep_left) {
+                ans.left.push_back(static_cast<row_id_t>(i));
+                ans.right.push_back(null_row);
+            }
+            continue;
+        }
+        for (size_t j = first; j < last; j++) {
+            ans.left.push_back(static_cast<row_id_t>(i));
+            ans.right.push_back(static_cast<row_id_t>(j));
+            if (keep_right) right_matched[j] = 1;
+        }
+    }
+    for (size_t j = 0; j < nr && keep_right; j++) {
+        if (right_matched[j]) continue;
+        ans.left.push_back(null_row);
+        ans.right.push_back(static_cast<row_id_t>(j));
+    }
+    return ans;
+}
+namespace detail {
+/* a join key column in ascending order, the column itself when it is known to be ascending, otherwise a
+ * sorted copy with the rows it came from, NaN last */
+template<typename T>
+struct ascending_column {
+    ascending_column(const T* data, size_t n, bool ascending, thread_pool& pool): values(data) {
+        if (ascending || !n) return;
+        normalized_keys keys(n);
+        keys.add_column(data, true, null_order::last);
+        rows = keys.argsort(true, pool);
+        sorted.resize(n);
+        for (size_t i = 0; i < n; i++) sorted[i] = data[rows[i]];
+        values = sorted.data();
+    }
+    row_id_t row(size_t i) const { return rows.empty() ? static_cast<row_id_t>(i) : rows[i]; }
+    const T* values;
+    std::vector<row_id_t> rows;
+    std::vector<T> sorted;
+};
+}
+}}}
+
+#endif
@@ -0,0 +1,293 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_PREDICATE_
+#define _BOOST_UBLAS_DATA_FRAME_PREDICATE_
+#include <boost/endian/conversion.hpp>
+#include "data_frame_selection.hpp"
+#include "data_frame_thread_pool.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+namespace detail {
+inline int popcount64(std::uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(w);
+#else
+    int n = 0;
+    for (; w; w &= w - 1) ++n;
+    return n;
+#endif
+}
+inline int countr_zero64(std::uint64_t w) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(w);
+#else
+    int n = 0;
+    for (; !(w & 1); w >>= 1) ++n;
+    return n;
+#endif
+}
+/* pack 8 bytes holding 0 or 1 into the low 8 bits, byte j becomes bit j */
+inline std::uint64_t pack_flags8(const unsigned char* flags) {
+    std::uint64_t x;
+    std::memcpy(&x, flags, sizeof(x));
+    x = boost::endian::little_to_native(x);
+    return (x * 0x0102040810204080ULL) >> 56;
+}
+}
+/** @brief selection_mask is a bit-packed row selection, bit i is set when row i is selected.
+ * It's produced by the built-in predicates and only expanded to row indexes on demand.
+ */
+class selection_mask {
+public:
+    using word_type = std::uint64_t;
+    static constexpr size_t word_bits = 64;
+    /** @brief Build an empty selection_mask
+    */
+    selection_mask(): rows(0) {}
+    /** @brief Build a selection_mask for @code rows @endcode rows
+    *
+    * @param rows number of rows covered by the mask
+    *
+    * @param value initial state for every row
+    */
+    explicit selection_mask(size_t rows, bool value = false):
+        rows(rows), bits((rows + word_bits - 1) / word_bits, value ? ~word_type(0) : word_type(0)) {
+        clear_tail();
+    }
+    /** @brief number of rows covered by the mask
+    */
+    size_t size() const { return rows; }
+    /** @brief number of 64-bit words backing the mask
+    */
+    size_t word_count() const { return bits.size(); }
+    word_type* words() { return bits.data(); }
+    const word_type* words() const { return bits.data(); }
+    bool test(size_t pos) const {
+        return (bits[pos / word_bits] >> (pos % word_bits)) & 1;
+    }
+    void set(size_t pos) {
+        bits[pos / word_bits] |= word_type(1) << (pos % word_bits);
+    }
+    void reset(size_t pos) {
+        bits[pos / word_bits] &= ~(word_type(1) << (pos % word_bits));
+    }
+    /** @brief number of selected rows
+    */
+    size_t count() const {
+        size_t n = 0;
+        for (word_type w: bits) n += detail::popcount64(w);
+        return n;
+    }
+    bool any() const {
+        return std::any_of(bits.begin(), bits.end(), [](word_type w) { return w != 0; });
+    }
+    bool none() const { return !any(); }
+    selection_mask& operator&=(const selection_mask& other) {
+        assert(rows == other.rows);
+        for (size_t i = 0; i < bits.size(); i++) bits[i] &= other.bits[i];
+        return *this;
+    }
+    selection_mask& operator|=(const selection_mask& other) {
+        assert(rows == other.rows);
+        for (size_t i = 0; i < bits.size(); i++) bits[i] |= other.bits[i];
+        return *this;
+    }
+    selection_mask& flip() {
+        for (auto& w: bits) w = ~w;
+        clear_tail();
+        return *this;
+    }
+    /** @brief expand the mask into ascending row indexes
+    */
+    std::vector<row_id_t> to_index() const {
+        std::vector<row_id_t> index;
+        index.reserve(count());
+        for (size_t i = 0; i < bits.size(); i++) {
+            for (word_type w = bits[i]; w; w &= w - 1)
+                index.push_back(static_cast<row_id_t>(i * word_bits + detail::countr_zero64(w)));
+        }
+        return index;
+    }
+private:
+    void clear_tail() {
+        if (rows % word_bits)
+            bits.back() &= (word_type(1) << (rows % word_bits)) - 1;
+    }
+    size_t rows;
+    std::vector<word_type> bits;
+};
+inline selection_mask operator&(selection_mask l, const selection_mask& r) { return l &= r; }
+inline selection_mask operator|(selection_mask l, const selection_mask& r) { return l |= r; }
+/** @brief base class for built-in predicates, @code select @endcode evaluates them with block kernels
+ * instead of calling them once per row
+ */
+struct column_predicate {};
+template<typename F>
+constexpr bool is_column_predicate_v = std::is_base_of_v<column_predicate, std::decay_t<F>>;
+template<typename T>
+struct less_than: column_predicate {
+    T value;
+    explicit less_than(T v): value(std::move(v)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return x < value; }
+};
+template<typename T>
+struct less_equal: column_predicate {
+    T value;
+    explicit less_equal(T v): value(std::move(v)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return x <= value; }
+};
+template<typename T>
+struct greater_than: column_predicate {
+    T value;
+    explicit greater_than(T v): value(std::move(v)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return x > value; }
+};
+template<typename T>
+struct greater_equal: column_predicate {
+    T value;
+    explicit greater_equal(T v): value(std::move(v)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return x >= value; }
+};
+template<typename T>
+struct equal_to: column_predicate {
+    T value;
+    explicit equal_to(T v): value(std::move(v)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return x == value; }
+};
+/** @brief closed interval @code [low, high] @endcode
+ */
+template<typename T>
+struct between_values: column_predicate {
+    T low, high;
+    between_values(T l, T h): low(std::move(l)), high(std::move(h)) {}
+    template<typename U>
+    bool operator()(const U& x) const { return (x >= low) & (x <= high); }
+};
+/** @brief membership in a small set of values, large sets are searched with binary search
+ */
+template<typename T>
+struct in_values: column_predicate {
+    std::vector<T> values;
+    explicit in_values(std::vector<T> v): values(std::move(v)) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+    template<typename U>
+    bool operator()(const U& x) const {
+        if (values.size() > 16)
+            return std::binary_search(values.begin(), values.end(), x);
+        bool found = false;
+        for (const auto& v: values) found |= (x == v);
+        return found;
+    }
+};
+template<typename T> less_than<T> lt(T v) { return less_than<T>(std::move(v)); }
+template<typename T> less_equal<T> le(T v) { return less_equal<T>(std::move(v)); }
+template<typename T> greater_than<T> gt(T v) { return greater_than<T>(std::move(v)); }
+template<typename T> greater_equal<T> ge(T v) { return greater_equal<T>(std::move(v)); }
+template<typename T> equal_to<T> eq(T v) { return equal_to<T>(std::move(v)); }
+template<typename T> between_values<T> between(T low, T high) { return between_values<T>(std::move(low), std::move(high)); }
+template<typename T> in_values<T> in(std::initializer_list<T> v) { return in_values<T>(std::vector<T>(v)); }
+template<typename T> in_values<T> in(std::vector<T> v) { return in_values<T>(std::move(v)); }
+/** @brief evaluate a predicate over @code n @endcode contiguous values and write one bit per value into @code out @endcode
+ *
+ * Every block of 64 values is compared into a byte array first, which compiles to SIMD compares for
+ * arithmetic types, then packed into one mask word without branches.
+ *
+ * @tparam T value type
+ *
+ * @tparam Pred a built-in predicate or any functor returning bool
+ *
+ * @param data first value
+ *
+ * @param n number of values
+ *
+ * @param p predicate
+ *
+ * @param out destination words, must hold @code (n + 63) / 64 @endcode words
+ */
+template<typename T, typename Pred>
+void evaluate_predicate(const T* data, size_t n, const Pred& p, selection_mask::word_type* out) {
+    constexpr size_t word_bits = selection_mask::word_bits;
+    alignas(64) unsigned char flags[word_bits];
+    size_t full = n / word_bits;
+    for (size_t w = 0; w < full; w++) {
+        const T* block = data + w * word_bits;
+        for (size_t j = 0; j < word_bits; j++)
+            flags[j] = static_cast<unsigned char>(p(block[j]));
+        selection_mask::word_type bits = 0;
+        for (size_t j = 0; j < word_bits / 8; j++)
+            bits |= detail::pack_flags8(flags + j * 8) << (j * 8);
+        out[w] = bits;
+    }
+    size_t rest = n - full * word_bits;
+    if (rest) {
+        const T* block = data + full * word_bits;
+        selection_mask::word_type bits = 0;
+        for (size_t j = 0; j < rest; j++)
+            bits |= selection_mask::word_type(p(block[j]) ? 1 : 0) << j;
+        out[full] = bits;
+    }
+}
+/** @brief evaluate a selection over @code len @endcode rows on a thread pool and compact the selected rows
+ * into ascending indexes
+ *
+ * Every task owns a disjoint range of mask words: it evaluates them and counts the selected rows,
+ * a prefix sum over the counts gives each task its output offset and the tasks then scatter their rows
+ * without any locking. The result doesn't depend on the number of threads.
+ *
+ * @tparam Eval functor @code eval(first_row, rows, words) @endcode writing @code (rows + 63) / 64 @endcode mask words
+ *
+ * @param len number of rows
+ *
+ * @param eval the selection kernel, called concurrently on disjoint row ranges
+ *
+ * @param pool the threads to run on
+ */
+template<typename Eval>
+std::vector<row_id_t> parallel_compact(size_t len, Eval eval, thread_pool& pool) {
+    constexpr size_t word_bits = selection_mask::word_bits;
+    // keep task ranges a multiple of 16 words so block kernels see whole blocks
+    constexpr size_t word_granularity = 16;
+    selection_mask m(len);
+    size_t words = m.word_count();
+    if (!words) return {};
+    size_t tasks = std::min((words + word_granularity - 1) / word_granularity, pool.size() * 4);
+    size_t words_per_task = (words + tasks - 1) / tasks;
+    words_per_task = (words_per_task + word_granularity - 1) / word_granularity * word_granularity;
+    std::vector<size_t> offsets(tasks + 1, 0);
+    pool.parallel_for(tasks, [&](size_t t) {
+        size_t wb = std::min(words, t * words_per_task);
+        size_t we = std::min(words, wb + words_per_task);
+        if (wb == we) return;
+        size_t first = wb * word_bits;
+        eval(first, std::min(len, we * word_bits) - first, m.words() + wb);
+        size_t n = 0;
+        for (size_t w = wb; w < we; w++) n += detail::popcount64(m.words()[w]);
+        offsets[t + 1] = n;
+    });
+    for (size_t t = 0; t < tasks; t++) offsets[t + 1] += offsets[t];
+    std::vector<row_id_t> index(offsets[tasks]);
+    pool.parallel_for(tasks, [&](size_t t) {
+        size_t wb = std::min(words, t * words_per_task);
+        size_t we = std::min(words, wb + words_per_task);
+        row_id_t* out = index.data() + offsets[t];
+        for (size_t w = wb; w < we; w++) {
+            for (selection_mask::word_type bits = m.words()[w]; bits; bits &= bits - 1)
+                *out++ = static_cast<row_id_t>(w * word_bits + detail::countr_zero64(bits));
+        }
+    });
+    return index;
+}
+}}}
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_SELECTION_
+#define _BOOST_UBLAS_DATA_FRAME_SELECTION_
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <variant>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief position of a row in a data_frame, 64-bit so frames aren't limited to 2^31 rows
+ */
+using row_id_t = std::int64_t;
+/** @brief selection_vector is an ordered list of row ids stored in the narrowest unsigned type
+ * able to address the frame: 16 bits up to 65536 rows, 32 bits up to 2^32 rows, 64 bits above.
+ *
+ * Adding a row that doesn't fit widens the storage, so the width only has to be right for the common case.
+ * A contiguous run of rows, e.g. from a range or a binary search, is kept as its bounds until it's modified.
+ */
+class selection_vector {
+public:
+    /** @brief Build an empty selection_vector with 16-bit storage
+    */
+    selection_vector() = default;
+    /** @brief Build an empty selection_vector for rows of a frame with @code frame_rows @endcode rows
+    *
+    * @param frame_rows number of rows of the frame the row ids point into
+    */
+    explicit selection_vector(size_t frame_rows) { widen_for(frame_rows ? frame_rows - 1 : 0); }
+    /** @brief Build a selection_vector holding @code index @endcode
+    *
+    * @param index the row ids, in the order they are visited
+    *
+    * @param frame_rows number of rows of the frame the row ids point into
+    */
+    selection_vector(const std::vector<row_id_t>& index, size_t frame_rows): selection_vector(frame_rows) {
+        row_id_t hi = index.empty() ? 0 : *std::max_element(index.begin(), index.end());
+        widen_for(static_cast<std::uint64_t>(hi));
+        std::visit([&index](auto& rows) { rows.assign(index.begin(), index.end()); }, storage);
+    }
+    /** @brief Build a selection_vector holding the rows [first, last) without storing them
+    */
+    static selection_vector contiguous(row_id_t first, row_id_t last) {
+        selection_vector ans;
+        ans.span = true;
+        ans.span_first = first;
+        ans.span_size = last > first ? static_cast<size_t>(last - first) : 0;
+        ans.widen_for(static_cast<std::uint64_t>(ans.span_size ? last - 1 : 0));
+        return ans;
+    }
+    /** @brief whether the rows are a contiguous run kept as its bounds
+    */
+    bool is_contiguous() const { return span; }
+    /** @brief bytes used per row id, 2, 4 or 8, a contiguous run reports the width it is stored at once modified
+    */
+    size_t width() const {
+        return std::visit([](const auto& rows) { return sizeof(typename std::decay_t<decltype(rows)>::value_type); }, storage);
+    }
+    size_t size() const {
+        if (span) return span_size;
+        return std::visit([](const auto& rows) { return rows.size(); }, storage);
+    }
+    bool empty() const { return size() == 0; }
+    row_id_t operator[](size_t i) const {
+        if (span) return span_first + static_cast<row_id_t>(i);
+        return std::visit([i](const auto& rows) { return static_cast<row_id_t>(rows[i]); }, storage);
+    }
+    void reserve(size_t n) {
+        materialize();
+        std::visit([n](auto& rows) { rows.reserve(n); }, storage);
+    }
+    void clear() {
+        span = false;
+        std::visit([](auto& rows) { rows.clear(); }, storage);
+    }
+    void push_back(row_id_t row) {
+        materialize();
+        widen_for(static_cast<std::uint64_t>(row));
+        std::visit([row](auto& rows) {
+            rows.push_back(static_cast<typename std::decay_t<decltype(rows)>::value_type>(row));
+        }, storage);
+    }
+    /** @brief call @code f(row) @endcode for every row id in order
+    */
+    template<typename F>
+    void for_each(F f) const {
+        if (span) {
+            for (size_t i = 0; i < span_size; i++) f(span_first + static_cast<row_id_t>(i));
+            return;
+        }
+        std::visit([&f](const auto& rows) {
+            for (auto row: rows) f(static_cast<row_id_t>(row));
+        }, storage);
+    }
+    /** @brief keep only the row ids for which @code keep(row) @endcode is true, preserving their order
+    */
+    template<typename F>
+    void retain(F keep) {
+        materialize();
+        std::visit([&keep](auto& rows) {
+            rows.erase(std::remove_if(rows.begin(), rows.end(), [&keep](auto row) {
+                return !keep(static_cast<row_id_t>(row));
+            }), rows.end());
+        }, storage);
+    }
+    /** @brief expand into 64-bit row ids
+    */
+    std::vector<row_id_t> to_vector() const {
+        std::vector<row_id_t> ans;
+        ans.reserve(size());
+        for_each([&ans](row_id_t row) { ans.push_back(row); });
+        return ans;
+    }
+private:
+    void materialize() {
+        if (!span) return;
+        span = false;
+        widen_for(static_cast<std::uint64_t>(span_size ? span_first + span_size - 1 : 0));
+        std::visit([this](auto& rows) {
+            rows.resize(span_size);
+            for (size_t i = 0; i < span_size; i++)
+                rows[i] = static_cast<typename std::decay_t<decltype(rows)>::value_type>(span_first + i);
+        }, storage);
+    }
+    void widen_for(std::uint64_t row) {
+        if (row > std::numeric_limits<std::uint32_t>::max()) widen<std::uint64_t>();
+        else if (row > std::numeric_limits<std::uint16_t>::max()) widen<std::uint32_t>();
+    }
+    template<typename U>
+    void widen() {
+        if (width() >= sizeof(U)) return;
+        std::vector<U> wider;
+        std::visit([&wider](const auto& rows) { wider.assign(rows.begin(), rows.end()); }, storage);
+        storage = std::move(wider);
+    }
+    std::variant<std::vector<std::uint16_t>, std::vector<std::uint32_t>, std::vector<std::uint64_t>> storage;
+    bool span = false;
+    row_id_t span_first = 0;
+    size_t span_size = 0;
+};
+}}}
+
+#endif
@@ -0,0 +1,537 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_SORT_
+#define _BOOST_UBLAS_DATA_FRAME_SORT_
+#include "data_frame_selection.hpp"
+#include "data_frame_thread_pool.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <type_traits>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief inputs shorter than this are sorted on the calling thread
+ */
+constexpr size_t parallel_sort_min_rows = 1 << 14;
+namespace detail {
+/* number of elements taken from a among the first diag outputs of a stable merge of a and b */
+template<typename It, typename Cmp>
+size_t merge_path(It a, size_t na, It b, size_t nb, size_t diag, Cmp& cmp) {
+    size_t lo = diag > nb ? diag - nb : 0;
+    size_t hi = std::min(diag, na);
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        if (cmp(b[diag - i - 1], a[i])) hi = i;
+        else lo = i + 1;
+    }
+    return lo;
+}
+template<size_t N> struct radix_key_type;
+template<> struct radix_key_type<1> { using type = std::uint8_t; };
+template<> struct radix_key_type<2> { using type = std::uint16_t; };
+template<> struct radix_key_type<4> { using type = std::uint32_t; };
+template<> struct radix_key_type<8> { using type = std::uint64_t; };
+/* map a value to an unsigned key with the same order: flip the sign bit of signed integers,
+ * and for IEEE floats flip all bits of negatives and the sign bit of positives */
+template<typename T>
+auto radix_key(T x) {
+    using K = typename radix_key_type<sizeof(T)>::type;
+    constexpr K sign = K(1) << (sizeof(K) * 8 - 1);
+    if constexpr (std::is_floating_point_v<T>) {
+        if (x == 0) x = 0; // -0.0 and 0.0 compare equal
+        K bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return (bits & sign) ? K(~bits) : K(bits | sign);
+    } else if constexpr (std::is_signed_v<T>) {
+        return K(K(x) ^ sign);
+    } else {
+        return K(x);
+    }
+}
+}
+namespace detail {
+template<typename T, typename Cmp>
+void parallel_merge_sort(std::vector<T>& v, Cmp cmp, thread_pool& pool, bool stable) {
+    size_t n = v.size();
+    size_t runs = std::min(pool.size(), n / parallel_sort_min_rows);
+    auto sort_run = [&](auto first, auto last) {
+        if (stable) std::stable_sort(first, last, cmp);
+        else std::sort(first, last, cmp);
+    };
+    if (runs <= 1) {
+        sort_run(v.begin(), v.end());
+        return;
+    }
+    std::vector<size_t> bounds(runs + 1);
+    for (size_t i = 0; i <= runs; i++) bounds[i] = n * i / runs;
+    pool.parallel_for(runs, [&](size_t r) {
+        sort_run(v.begin() + bounds[r], v.begin() + bounds[r + 1]);
+    });
+    std::vector<T> buf(n);
+    while (bounds.size() > 2) {
+        size_t pairs = (bounds.size() - 1) / 2;
+        size_t parts = std::max<size_t>(1, pool.size() / pairs);
+        pool.parallel_for(pairs * parts, [&](size_t t) {
+            size_t p = t / parts, part = t % parts;
+            const T* a = v.data() + bounds[2 * p];
+            const T* b = v.data() + bounds[2 * p + 1];
+            size_t na = bounds[2 * p + 1] - bounds[2 * p];
+            size_t nb = bounds[2 * p + 2] - bounds[2 * p + 1];
+            size_t first = (na + nb) * part / parts;
+            size_t last = (na + nb) * (part + 1) / parts;
+            size_t ia = merge_path(a, na, b, nb, first, cmp);
+            size_t ja = merge_path(a, na, b, nb, last, cmp);
+            std::merge(a + ia, a + ja, b + (first - ia), b + (last - ja), buf.data() + bounds[2 * p] + first, cmp);
+        });
+        // an odd run out is carried to the next round unchanged
+        if ((bounds.size() - 1) % 2)
+            std::copy(v.begin() + bounds[bounds.size() - 2], v.end(), buf.begin() + bounds[bounds.size() - 2]);
+        std::vector<size_t> next;
+        for (size_t i = 0; i < bounds.size(); i += 2) next.push_back(bounds[i]);
+        if (next.back() != n) next.push_back(n);
+        bounds.swap(next);
+        v.swap(buf);
+    }
+}
+}
+/** @brief stable sort on a thread pool
+ *
+ * The input is cut into one run per thread, runs are sorted concurrently and then merged pairwise.
+ * Every merge is itself split into independent pieces along its merge path, so all threads stay busy
+ * up to the last merge. The result is the same as @code std::stable_sort @endcode for any number of threads.
+ *
+ * @tparam T element type
+ *
+ * @tparam Cmp strict weak ordering, it's called concurrently
+ *
+ * @param v the elements to sort
+ *
+ * @param cmp the ordering
+ *
+ * @param pool the threads to run on
+ */
+template<typename T, typename Cmp>
+void parallel_stable_sort(std::vector<T>& v, Cmp cmp, thread_pool& pool) {
+    detail::parallel_merge_sort(v, cmp, pool, true);
+}
+/** @brief sort on a thread pool like @code parallel_stable_sort @endcode, without keeping the order of
+ * equivalent elements inside a run
+ */
+template<typename T, typename Cmp>
+void parallel_sort(std::vector<T>& v, Cmp cmp, thread_pool& pool) {
+    detail::parallel_merge_sort(v, cmp, pool, false);
+}
+/** @brief return the row order sorting @code n @endcode values by @code cmp @endcode, ties keep their row order
+ *
+ * @tparam T value type
+ *
+ * @tparam Cmp strict weak ordering on values, it's called concurrently
+ *
+ * @param data first value
+ *
+ * @param n number of values
+ *
+ * @param cmp the ordering
+ *
+ * @param pool the threads to run on
+ */
+template<typename T, typename Cmp>
+std::vector<row_id_t> parallel_argsort(const T* data, size_t n, Cmp cmp, thread_pool& pool) {
+    std::vector<row_id_t> index(n);
+    std::iota(index.begin(), index.end(), row_id_t(0));
+    parallel_stable_sort(index, [data, &cmp](row_id_t l, row_id_t r) { return cmp(data[l], data[r]); }, pool);
+    return index;
+}
+/** @brief return the first @code k @endcode rows of the order defined by @code cmp @endcode without sorting
+ * all rows, ties are broken by row so the result equals the head of a stable sort
+ *
+ * Every task keeps a bounded heap of its best k rows over a slice of the data, the heaps are then merged
+ * and only the survivors are sorted.
+ *
+ * @tparam T value type
+ *
+ * @tparam Cmp strict weak ordering on values, it's called concurrently
+ *
+ * @param data first value
+ *
+ * @param n number of values
+ *
+ * @param k number of rows to keep
+ *
+ * @param cmp the ordering
+ *
+ * @param pool the threads to run on
+ */
+template<typename T, typename Cmp>
+std::vector<row_id_t> parallel_top_k(const T* data, size_t n, size_t k, Cmp cmp, thread_pool& pool) {
+    k = std::min(k, n);
+    if (!k) return {};
+    auto before = [data, &cmp](row_id_t l, row_id_t r) {
+        if (cmp(data[l], data[r])) return true;
+        return !cmp(data[r], data[l]) && l < r;
+    };
+    size_t tasks = std::max<size_t>(1, std::min(pool.size(), n / parallel_sort_min_rows));
+    std::vector<std::vector<row_id_t>> heaps(tasks);
+    pool.parallel_for(tasks, [&](size_t t) {
+        auto& heap = heaps[t];
+        heap.reserve(k);
+        // the heap top is the worst row kept so far
+        for (size_t i = n * t / tasks, e = n * (t + 1) / tasks; i < e; i++) {
+            row_id_t row = static_cast<row_id_t>(i);
+            if (heap.size() < k) {
+                heap.push_back(row);
+                std::push_heap(heap.begin(), heap.end(), before);
+            } else if (before(row, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = row;
+                std::push_heap(heap.begin(), heap.end(), before);
+            }
+        }
+    });
+    std::vector<row_id_t> ans;
+    for (const auto& heap: heaps) ans.insert(ans.end(), heap.begin(), heap.end());
+    std::partial_sort(ans.begin(), ans.begin() + k, ans.end(), before);
+    ans.resize(k);
+    return ans;
+}
+namespace detail {
+/* orderings used by nlargest and nsmallest, NaN goes last like in radix_argsort */
+struct greater_nan_last {
+    template<typename T>
+    bool operator()(const T& l, const T& r) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(r)) return !std::isnan(l);
+        }
+        return l > r;
+    }
+};
+struct less_nan_last {
+    template<typename T>
+    bool operator()(const T& l, const T& r) const {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(r)) return !std::isnan(l);
+        }
+        return l < r;
+    }
+};
+}
+/** @brief whether @code radix_argsort @endcode supports T: integral types and 32/64-bit IEEE floating types
+ */
+template<typename T>
+constexpr bool is_radix_sortable_v = std::is_integral_v<T> ||
+    (std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 && (sizeof(T) == 4 || sizeof(T) == 8));
+/** @brief stable LSD radix sort of unsigned keys carrying row ids, one byte per pass on a thread pool
+ *
+ * Every pass counts digits per task, turns the counts into per-task output offsets and scatters without
+ * locking. Passes where all keys share the digit are skipped.
+ *
+ * @tparam K unsigned key type
+ *
+ * @param keys the keys, sorted in place
+ *
+ * @param rows the row ids travelling with the keys
+ *
+ * @param pool the threads to run on
+ */
+template<typename K>
+void parallel_radix_sort(std::vector<K>& keys, std::vector<row_id_t>& rows, thread_pool& pool) {
+    constexpr size_t radix = 256;
+    size_t n = keys.size();
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+    std::vector<K> key_buf(n);
+    std::vector<row_id_t> row_buf(n);
+    std::vector<size_t> counts(tasks * radix);
+    for (size_t shift = 0; shift < sizeof(K) * 8; shift += 8) {
+        std::fill(counts.begin(), counts.end(), 0);
+        pool.parallel_for(tasks, [&](size_t t) {
+            size_t* c = counts.data() + t * radix;
+            for (size_t i = n * t / tasks, e = n * (t + 1) / tasks; i < e; i++) ++c[(keys[i] >> shift) & 0xFF];
+        });
+        bool trivial = false;
+        for (size_t d = 0; d < radix && !trivial; d++) {
+            size_t total = 0;
+            for (size_t t = 0; t < tasks; t++) total += counts[t * radix + d];
+            trivial = total == n;
+        }
+        if (trivial) continue;
+        size_t offset = 0;
+        for (size_t d = 0; d < radix; d++) {
+            for (size_t t = 0; t < tasks; t++) {
+                size_t c = counts[t * radix + d];
+                counts[t * radix + d] = offset;
+                offset += c;
+            }
+        }
+        pool.parallel_for(tasks, [&](size_t t) {
+            size_t* c = counts.data() + t * radix;
+            for (size_t i = n * t / tasks, e = n * (t + 1) / tasks; i < e; i++) {
+                size_t pos = c[(keys[i] >> shift) & 0xFF]++;
+                key_buf[pos] = keys[i];
+                row_buf[pos] = rows[i];
+            }
+        });
+        keys.swap(key_buf);
+        rows.swap(row_buf);
+    }
+}
+/** @brief return the row order sorting @code n @endcode arithmetic values with a radix sort,
+ * ties keep their row order and NaN values go last in both directions
+ *
+ * @tparam T a type with @code is_radix_sortable_v<T> @endcode
+ *
+ * @param data first value
+ *
+ * @param n number of values
+ *
+ * @param descending largest value first when true
+ *
+ * @param pool the threads to run on
+ */
+template<typename T>
+std::vector<row_id_t> radix_argsort(const T* data, size_t n, bool descending, thread_pool& pool) {
+    static_assert(is_radix_sortable_v<T>, "radix_argsort needs an integral or IEEE floating type");
+    using K = typename detail::radix_key_type<sizeof(T)>::type;
+    std::vector<K> keys(n);
+    std::vector<row_id_t> rows(n);
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+    pool.parallel_for(tasks, [&](size_t t) {
+        for (size_t i = n * t / tasks, e = n * (t + 1) / tasks; i < e; i++) {
+            K key = detail::radix_key(data[i]);
+            if (descending) key = K(~key);
+            if constexpr (std::is_floating_point_v<T>) {
+                if (std::isnan(data[i])) key = K(~K(0));
+            }
+            keys[i] = key;
+            rows[i] = static_cast<row_id_t>(i);
+        }
+    });
+    parallel_radix_sort(keys, rows, pool);
+    return rows;
+}
+namespace detail {
+/* bytes [depth, depth + 8) of s as a big-endian integer, padded with zeros */
+inline std::uint64_t string_prefix(const std::string& s, size_t depth) {
+    std::uint64_t key = 0;
+    for (size_t i = depth; i < depth + 8; i++)
+        key = (key << 8) | (i < s.size() ? static_cast<unsigned char>(s[i]) : 0);
+    return key;
+}
+/* sort rows whose strings share their first depth bytes, 8 bytes per level. Comparing the prefix and
+ * then the remaining length (capped at 9) gives the string order: strings with equal padded prefixes
+ * and at most 8 bytes left only differ by trailing zeros, so the shorter one is smaller, and only rows
+ * with more than 8 bytes left go one level deeper */
+inline void sort_string_suffixes(const std::string* data, row_id_t* rows, size_t n, size_t depth, bool descending) {
+    struct entry {
+        std::uint64_t key;
+        std::uint8_t left;
+        row_id_t row;
+    };
+    std::vector<entry> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        const std::string& s = data[rows[i]];
+        entries[i] = {string_prefix(s, depth), static_cast<std::uint8_t>(s.size() > depth ? std::min<size_t>(s.size() - depth, 9) : 0), rows[i]};
+    }
+    auto before = [descending](const entry& l, const entry& r) {
+        if (l.key != r.key) return descending ? l.key > r.key : l.key < r.key;
+        return descending ? l.left > r.left : l.left < r.left;
+    };
+    std::stable_sort(entries.begin(), entries.end(), before);
+    for (size_t i = 0; i < n; i++) rows[i] = entries[i].row;
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        while (last < n && entries[last].key == entries[first].key && entries[last].left == entries[first].left) ++last;
+        if (last - first > 1 && entries[first].left > 8) sort_string_suffixes(data, rows + first, last - first, depth + 8, descending);
+        first = last;
+    }
+}
+}
+/** @brief return the row order sorting @code n @endcode strings, ties keep their row order
+ *
+ * The first 8 bytes of every string are cached next to its row as a big-endian integer and radix sorted,
+ * so most comparisons never touch the string. Rows with equal prefixes are sorted concurrently by the
+ * next 8 bytes, and so on until they are told apart.
+ *
+ * @param data first string
+ *
+ * @param n number of strings
+ *
+ * @param descending largest string first when true
+ *
+ * @param pool the threads to run on
+ */
+inline std::vector<row_id_t> string_argsort(const std::string* data, size_t n, bool descending, thread_pool& pool) {
+    std::vector<std::uint64_t> keys(n);
+    std::vector<row_id_t> rows(n);
+    size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, n / parallel_sort_min_rows));
+    pool.parallel_for(tasks, [&](size_t t) {
+        for (size_t i = n * t / tasks, e = n * (t + 1) / tasks; i < e; i++) {
+            std::uint64_t key = detail::string_prefix(data[i], 0);
+            keys[i] = descending ? ~key : key;
+            rows[i] = static_cast<row_id_t>(i);
+        }
+    });
+    parallel_radix_sort(keys, rows, pool);
+    // runs of equal prefixes, told apart by their length and the bytes after the prefix
+    std::vector<std::pair<size_t, size_t>> ties;
+    for (size_t first = 0; first < n;) {
+        size_t last = first + 1;
+        while (last < n && keys[last] == keys[first]) ++last;
+        if (last - first > 1) ties.emplace_back(first, last);
+        first = last;
+    }
+    tasks = std::max<size_t>(1, std::min(pool.size() * 4, ties.size()));
+    pool.parallel_for(tasks, [&](size_t t) {
+        for (size_t i = ties.size() * t / tasks, e = ties.size() * (t + 1) / tasks; i < e; i++)
+            detail::sort_string_suffixes(data, rows.data() + ties[i].first, ties[i].second - ties[i].first, 0, descending);
+    });
+    return rows;
+}
+/** @brief placement of null values in a sort, NaN is the null value of floating point columns
+ */
+enum class null_order { first, last };
+/** @brief one key of a multi-column sort
+ */
+struct sort_key {
+    sort_key(std::string col_name, bool ascending = true, null_order nulls = null_order::last):
+        col_name(std::move(col_name)), ascending(ascending), nulls(nulls) {}
+    std::string col_name;
+    bool ascending;
+    null_order nulls;
+};
+/** @brief normalized_keys encodes several sort columns into one byte string per row, so that comparing
+ * two rows is a single @code memcmp @endcode
+ *
+ * Arithmetic values are written big-endian after the order-preserving radix mapping, strings are written
+ * with 0x00 escaped as 0x00 0xFF and a 0x00 0x00 terminator. Descending keys have their bytes inverted,
+ * and floating point keys are preceded by a byte placing NaN first or last.
+ */
+class normalized_keys {
+public:
+    /** @brief Build the keys of @code rows @endcode rows, columns are added with @code add_column @endcode
+    */
+    explicit normalized_keys(size_t rows): rows(rows) {}
+    /** @brief append a sort column
+    *
+    * @tparam T an arithmetic type or @code std::string @endcode
+    *
+    * @param data first value of the column, it must stay valid until @code argsort @endcode
+    *
+    * @param ascending the direction of this key
+    *
+    * @param nulls where NaN values go
+    */
+    template<typename T>
+    void add_column(const T* data, bool ascending, null_order nulls) {
+        static_assert(is_supported_v<T>, "normalized keys need an arithmetic or string column");
+        if constexpr (std::is_same_v<T, std::string>) {
+            fixed = false;
+            columns.push_back({[data](size_t row) {
+                const std::string& v = data[row];
+                return v.size() + std::count(v.begin(), v.end(), '\0') + 2;
+            }, [data, ascending](size_t row, unsigned char* out) {
+                unsigned char* first = out;
+                for (unsigned char c: data[row]) {
+                    *out++ = c;
+                    if (!c) *out++ = 0xFF;
+                }
+                *out++ = 0;
+                *out++ = 0;
+                if (!ascending) invert(first, out);
+                return out;
+            }});
+        } else {
+            using K = typename detail::radix_key_type<sizeof(T)>::type;
+            constexpr size_t width = sizeof(K) + (std::is_floating_point_v<T> ? 1 : 0);
+            fixed_width += width;
+            columns.push_back({[](size_t) { return width; }, [data, ascending, nulls](size_t row, unsigned char* out) {
+                if constexpr (std::is_floating_point_v<T>) {
+                    bool null = std::isnan(data[row]);
+                    *out++ = (null == (nulls == null_order::last)) ? 1 : 0;
+                    if (null) {
+                        std::fill(out, out + sizeof(K), 0);
+                        return out + sizeof(K);
+                    }
+                }
+                K key = detail::radix_key(data[row]);
+                if (!ascending) key = K(~key);
+                for (size_t i = 0; i < sizeof(K); i++)
+                    *out++ = static_cast<unsigned char>(key >> (8 * (sizeof(K) - 1 - i)));
+                return out;
+            }});
+        }
+    }
+    template<typename T>
+    static constexpr bool is_supported_v = is_radix_sortable_v<T> || std::is_same_v<T, std::string>;
+    /** @brief return the row order sorting by all added columns, the first column is the most significant
+    *
+    * Keys of at most 8 bytes are radix sorted, longer ones are merge sorted with @code memcmp @endcode.
+    *
+    * @param stable whether rows with equal keys keep their order
+    *
+    * @param pool the threads to run on
+    */
+    std::vector<row_id_t> argsort(bool stable, thread_pool& pool) const {
+        std::vector<row_id_t> index(rows);
+        std::iota(index.begin(), index.end(), row_id_t(0));
+        if (fixed && fixed_width <= sizeof(std::uint64_t)) {
+            std::vector<std::uint64_t> keys(rows);
+            size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, rows / parallel_sort_min_rows));
+            pool.parallel_for(tasks, [&](size_t t) {
+                unsigned char buf[sizeof(std::uint64_t)];
+                for (size_t i = rows * t / tasks, e = rows * (t + 1) / tasks; i < e; i++) {
+                    encode(i, buf);
+                    std::uint64_t key = 0;
+                    for (size_t b = 0; b < fixed_width; b++) key = (key << 8) | buf[b];
+                    keys[i] = key;
+                }
+            });
+            parallel_radix_sort(keys, index, pool);
+            return index;
+        }
+        std::vector<size_t> offsets(rows + 1, 0);
+        for (size_t i = 0; i < rows; i++) {
+            size_t len = fixed_width;
+            if (!fixed) {
+                len = 0;
+                for (const auto& c: columns) len += c.width(i);
+            }
+            offsets[i + 1] = offsets[i] + len;
+        }
+        std::vector<unsigned char> bytes(offsets[rows]);
+        size_t tasks = std::max<size_t>(1, std::min(pool.size() * 4, rows / parallel_sort_min_rows));
+        pool.parallel_for(tasks, [&](size_t t) {
+            for (size_t i = rows * t / tasks, e = rows * (t + 1) / tasks; i < e; i++) encode(i, bytes.data() + offsets[i]);
+        });
+        const unsigned char* base = bytes.data();
+        const size_t* off = offsets.data();
+        auto cmp = [base, off](row_id_t l, row_id_t r) {
+            size_t ll = off[l + 1] - off[l], rl = off[r + 1] - off[r];
+            int c = std::memcmp(base + off[l], base + off[r], std::min(ll, rl));
+            return c ? c < 0 : ll < rl;
+        };
+        if (stable) parallel_stable_sort(index, cmp, pool);
+        else parallel_sort(index, cmp, pool);
+        return index;
+    }
+private:
+    struct column {
+        std::function<size_t(size_t)> width;
+        std::function<unsigned char*(size_t, unsigned char*)> write;
+    };
+    static void invert(unsigned char* first, unsigned char* last) {
+        for (; first != last; ++first) *first = static_cast<unsigned char>(~*first);
+    }
+    void encode(size_t row, unsigned char* out) const {
+        for (const auto& c: columns) out = c.write(row, out);
+    }
+    size_t rows;
+    size_t fixed_width = 0;
+    bool fixed = true;
+    std::vector<column> columns;
+};
+}}}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef _BOOST_UBLAS_DATA_FRAME_THREAD_POOL_
+#define _BOOST_UBLAS_DATA_FRAME_THREAD_POOL_
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+namespace boost { namespace numeric { namespace ublas {
+/** @brief a fixed set of worker threads used by the parallel data_frame operators
+ *
+ * Work is submitted as a number of independent tasks, idle workers and the calling thread
+ * keep taking the next task until all of them have run.
+ */
+class thread_pool {
+public:
+    /** @brief Build a thread_pool
+    *
+    * @param threads total number of threads taking part in @code parallel_for @endcode, including the caller
+    */
+    explicit thread_pool(size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (size_t i = 1; i < threads; i++)
+            workers.emplace_back([this] { work(); });
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    ~thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            stopping = true;
+        }
+        queue_cv.notify_all();
+        for (auto& t: workers) t.join();
+    }
+    /** @brief number of threads taking part in @code parallel_for @endcode
+    */
+    size_t size() const { return workers.size() + 1; }
+    /** @brief run @code f(task) @endcode for every task in [0, tasks) and wait for all of them
+    *
+    * @tparam F functor taking the task number
+    *
+    * @param tasks number of tasks
+    *
+    * @param f the task body, the first exception thrown is rethrown in the caller
+    */
+    template<typename F>
+    void parallel_for(size_t tasks, F&& f) {
+        if (tasks == 0) return;
+        if (tasks == 1 || workers.empty()) {
+            for (size_t i = 0; i < tasks; i++) f(i);
+            return;
+        }
+        // the state outlives this call if a helper is only scheduled after every task finished
+        struct job_state {
+            std::atomic<size_t> next{0};
+            size_t done = 0;
+            std::mutex m;
+            std::condition_variable cv;
+            std::exception_ptr error;
+        };
+        auto state = std::make_shared<job_state>();
+        std::function<void(size_t)> body = std::forward<F>(f);
+        auto run = [state, tasks, body]() {
+            size_t finished = 0;
+            std::exception_ptr error;
+            for (size_t i = state->next++; i < tasks; i = state->next++) {
+                try {
+                    body(i);
+                } catch (...) {
+                    if (!error) error = std::current_exception();
+                }
+                ++finished;
+            }
+            if (!finished) return;
+            std::lock_guard<std::mutex> lock(state->m);
+            if (error && !state->error) state->error = error;
+            state->done += finished;
+            if (state->done == tasks) state->cv.notify_all();
+        };
+        size_t helpers = std::min(tasks - 1, workers.size());
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            for (size_t i = 0; i < helpers; i++) jobs.emplace_back(run);
+        }
+        queue_cv.notify_all();
+        run();
+        std::unique_lock<std::mutex> lock(state->m);
+        state->cv.wait(lock, [&] { return state->done == tasks; });
+        if (state->error) std::rethrow_exception(state->error);
+    }
+private:
+    void work() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(queue_mutex);
+                queue_cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return;
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex queue_mutex;
+    std::condition_variable queue_cv;
+    bool stopping = false;
+};
+/** @brief the pool shared by parallel operators when none is given, sized to the hardware concurrency
+ */
+inline thread_pool& default_thread_pool() {
+    static thread_pool pool;
+    return pool;
+}
+}}}
+
+#endif
@@ -4,7 +4,13 @@
 #include <boost/numeric/ublas/storage.hpp>
 #include <boost/test/unit_test.hpp>
 #include "data_frame.hpp"
+#include "data_frame_external_sort.hpp"
 #include <vector>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <filesystem>
+#include <random>
 #include <iostream>
 #include <tuple>
 #include <typeinfo>
@@ -73,7 +79,7 @@ BOOST_AUTO_TEST_CASE(data_frame_sort_with_single_column) {
                                 std::make_tuple(2, 2.2, "world"s), 
                                 std::make_tuple(3, 1.1, "bili"s)}, 
                     {"int_vec", "double_vec", "str_vec"});
-    std::vector<int> new_index = df2.order<int>("int_vec");
+    std::vector<row_id_t> new_index = df2.order<int>("int_vec");
     int len = df2.get_cur_rows();
     for (int i = 0; i < len; i++)
         std::cout << new_index[i] << " ";
@@ -271,6 +277,407 @@ BOOST_AUTO_TEST_CASE(data_frame_combine_data_frames) {
     BOOST_CHECK_EQUAL(df13.get_cur_cols(), 4);
     df13.print_with_index({0, 1, 2, 3, 4, 5});    
 }
+BOOST_AUTO_TEST_CASE(data_frame_hash_join) {
+    // nested loop reference: left row order, matching right rows ascending, then unmatched right rows
+    auto nested_loop = [](const std::vector<double>& l, const std::vector<double>& r, join_kind kind) {
+        join_pairs ans;
+        std::vector<char> matched(r.size(), 0);
+        for (size_t i = 0; i < l.size(); i++) {
+            bool hit = false;
+            for (size_t j = 0; j < r.size(); j++) {
+                if (l[i] != r[j]) continue;
+                ans.left.push_back(i);
+                ans.right.push_back(j);
+                matched[j] = hit = true;
+            }
+            if (!hit && (kind == join_kind::left || kind == join_kind::full)) {
+                ans.left.push_back(i);
+                ans.right.push_back(null_row);
+            }
+        }
+        for (size_t j = 0; j < r.size() && (kind == join_kind::right || kind == join_kind::full); j++) {
+            if (matched[j]) continue;
+            ans.left.push_back(null_row);
+            ans.right.push_back(j);
+        }
+        return ans;
+    };
+    std::vector<double> small_vec, large_vec;
+    for (int i = 0; i < 300; i++) small_vec.push_back(i % 40 * 0.5);
+    for (int i = 0; i < 2000; i++) large_vec.push_back(i * 7 % 101 * 0.5);
+    small_vec[3] = large_vec[5] = std::numeric_limits<double>::quiet_NaN();
+    small_vec[4] = -0.0;
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        // built on the right side, then on the left side
+        auto a = hash_join(column_join_key<double>(large_vec.data(), large_vec.size(), small_vec.data(), small_vec.size()), kind);
+        auto b = hash_join(column_join_key<double>(small_vec.data(), small_vec.size(), large_vec.data(), large_vec.size()), kind);
+        auto ea = nested_loop(large_vec, small_vec, kind);
+        auto eb = nested_loop(small_vec, large_vec, kind);
+        BOOST_CHECK(a.left == ea.left && a.right == ea.right);
+        BOOST_CHECK(b.left == eb.left && b.right == eb.right);
+    }
+    // NaN keys stay out of the table, many of them join in linear time and match nothing
+    std::vector<double> nan_left(40000, std::numeric_limits<double>::quiet_NaN()), nan_right(30000, std::numeric_limits<double>::quiet_NaN());
+    nan_left[7] = nan_right[11] = nan_right[12] = 2.5;
+    for (auto sides: {std::make_pair(&nan_left, &nan_right), std::make_pair(&nan_right, &nan_left)}) {
+        column_join_key<double> key(sides.first->data(), sides.first->size(), sides.second->data(), sides.second->size());
+        size_t nl = sides.first->size(), nr = sides.second->size();
+        auto inner = hash_join(key, join_kind::inner);
+        BOOST_CHECK_EQUAL(inner.left.size(), 2);
+        BOOST_CHECK_EQUAL((*sides.first)[inner.left[0]], 2.5);
+        BOOST_CHECK_EQUAL((*sides.second)[inner.right[1]], 2.5);
+        BOOST_CHECK_EQUAL(hash_join(key, join_kind::left).left.size(), inner.left.size() + nl - (nl == 40000 ? 1 : 2));
+        BOOST_CHECK_EQUAL(hash_join(key, join_kind::right).left.size(), inner.left.size() + nr - (nr == 40000 ? 1 : 2));
+        BOOST_CHECK_EQUAL(hash_join(key, join_kind::full).left.size(), inner.left.size() + nl + nr - 3);
+    }
+    using type_collection1 = type_list<std::string, long>::types;
+    using type_collection2 = type_list<std::string, int>::types;
+    data_frame df1 = type_collection1{};
+    data_frame df2 = type_collection2{};
+    df1.add_column("sym", std::vector<std::string>{"a", "b", "c"});
+    df1.add_column("qty", std::vector<long>{1, 2, 3});
+    df2.add_column("sym", std::vector<std::string>{"x", "y"});
+    df2.add_column("px", std::vector<int>{7, 8});
+    auto df3 = df1.combine_inner<std::string>(df2, "sym",
+                                    std::tuple<std::string, long>{}, {"sym", "qty"},
+                                    std::tuple<std::string, int>{}, {"sym", "px"});
+    BOOST_CHECK_EQUAL(df3.get_cur_rows(), 0);
+    auto df4 = df1.combine_full<std::string>(df2, "sym",
+                                    std::tuple<std::string, long>{}, {"sym", "qty"},
+                                    std::tuple<std::string, int>{}, {"sym", "px"});
+    BOOST_CHECK_EQUAL(df4.get_cur_rows(), 5);
+    BOOST_CHECK_EQUAL(df4.get_c<std::string>("sym", 0), "a");
+    BOOST_CHECK_EQUAL(df4.get_c<std::string>("sym", 4), "y");
+    BOOST_CHECK_EQUAL(df4.get_c<long>("qty", 4), 0);
+    BOOST_CHECK_EQUAL(df4.get_c<int>("px", 0), 0);
+    BOOST_CHECK_EQUAL(df4.get_c<int>("px", 4), 8);
+}
+BOOST_AUTO_TEST_CASE(data_frame_merge_join) {
+    std::vector<long> trades, quotes;
+    for (long i = 0; i < 3000; i++) trades.push_back(i / 3 * 2);
+    for (long i = 0; i < 2000; i++) quotes.push_back(i / 2 * 3 + 1);
+    std::vector<long> trades_desc(trades.rbegin(), trades.rend()), quotes_desc(quotes.rbegin(), quotes.rend());
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        auto merged = merge_join(trades.data(), trades.size(), quotes.data(), quotes.size(), sort_order::ascending, kind);
+        auto hashed = hash_join(column_join_key<long>(trades.data(), trades.size(), quotes.data(), quotes.size()), kind);
+        BOOST_CHECK(merged.left == hashed.left && merged.right == hashed.right);
+        merged = merge_join(trades_desc.data(), trades_desc.size(), quotes_desc.data(), quotes_desc.size(), sort_order::descending, kind);
+        hashed = hash_join(column_join_key<long>(trades_desc.data(), trades_desc.size(), quotes_desc.data(), quotes_desc.size()), kind);
+        BOOST_CHECK(merged.left == hashed.left && merged.right == hashed.right);
+    }
+    using type_collection = type_list<long, int>::types;
+    data_frame df1(type_collection{});
+    data_frame df2(type_collection{});
+    df1.add_column("ts", trades);
+    df1.add_column("qty", std::vector<int>(trades.size(), 1));
+    df2.add_column("ts", quotes);
+    df2.add_column("bid", std::vector<int>(quotes.size(), 2));
+    BOOST_CHECK(df1.get_sort_order("ts") == sort_order::ascending);
+    BOOST_CHECK(df2.get_sort_order("ts") == sort_order::ascending);
+    auto merged_df = df1.combine_full<long>(df2, "ts", std::tuple<long, int>{}, {"ts", "qty"}, std::tuple<long, int>{}, {"ts", "bid"});
+    df2.declare_sorted("ts", sort_order::none);
+    auto hashed_df = df1.combine_full<long>(df2, "ts", std::tuple<long, int>{}, {"ts", "qty"}, std::tuple<long, int>{}, {"ts", "bid"});
+    BOOST_CHECK_EQUAL(merged_df.get_cur_rows(), hashed_df.get_cur_rows());
+    bool same = true;
+    for (row_id_t i = 0; i < merged_df.get_cur_rows(); i++)
+        same = same && merged_df.get_c<long>("ts", i) == hashed_df.get_c<long>("ts", i) && merged_df.get_c<int>("bid", i) == hashed_df.get_c<int>("bid", i);
+    BOOST_CHECK(same);
+    df2.declare_sorted("ts", sort_order::ascending);
+    BOOST_CHECK(df2.get_sort_order("ts") == sort_order::ascending);
+}
+BOOST_AUTO_TEST_CASE(data_frame_parallel_hash_join) {
+    thread_pool pool(4);
+    std::vector<long> orders, customers;
+    for (long i = 0; i < 100000; i++) orders.push_back((i * 7919) % 30011);
+    for (long i = 0; i < 40000; i++) customers.push_back((i * 104729) % 50021 - 20000);
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        column_join_key<long> key(orders.data(), orders.size(), customers.data(), customers.size());
+        auto parallel = parallel_hash_join(key, kind, pool);
+        auto serial = hash_join(key, kind);
+        BOOST_CHECK(parallel.left == serial.left && parallel.right == serial.right);
+        column_join_key<long> swapped(customers.data(), customers.size(), orders.data(), orders.size());
+        parallel = parallel_hash_join(swapped, kind, pool);
+        serial = hash_join(swapped, kind);
+        BOOST_CHECK(parallel.left == serial.left && parallel.right == serial.right);
+    }
+    using type_collection = type_list<long, int>::types;
+    data_frame df1(type_collection{});
+    data_frame df2(type_collection{});
+    df1.add_column("id", orders);
+    df1.add_column("qty", std::vector<int>(orders.size(), 1));
+    df2.add_column("id", customers);
+    df2.add_column("tier", std::vector<int>(customers.size(), 2));
+    auto serial_df = combine_full<long>(df1, df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"});
+    auto parallel_df = parallel_combine_full<long>(df1, df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"}, pool);
+    BOOST_CHECK_EQUAL(serial_df->get_cur_rows(), parallel_df->get_cur_rows());
+    bool same = true;
+    for (row_id_t i = 0; i < serial_df->get_cur_rows(); i++)
+        same = same && serial_df->get_c<long>("id", i) == parallel_df->get_c<long>("id", i) && serial_df->get_c<int>("tier", i) == parallel_df->get_c<int>("tier", i);
+    BOOST_CHECK(same);
+    auto inner_df = parallel_combine_inner<long>(df1, df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"}, pool);
+    auto right_df = parallel_combine_right<long>(df1, df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"}, pool);
+    BOOST_CHECK_EQUAL(inner_df->get_cur_rows(), df1.combine_inner<long>(df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"}).get_cur_rows());
+    BOOST_CHECK_EQUAL(right_df->get_cur_rows(), df1.combine_right<long>(df2, "id", std::tuple<long, int>{}, {"id", "qty"}, std::tuple<long, int>{}, {"id", "tier"}).get_cur_rows());
+}
+BOOST_AUTO_TEST_CASE(data_frame_composite_join) {
+    std::vector<long> dates, days;
+    std::vector<std::string> syms, tickers;
+    for (int i = 0; i < 600; i++) {
+        dates.push_back(20190101 + i % 7);
+        syms.push_back(std::string(1, 'a' + i % 5));
+    }
+    for (int i = 0; i < 90; i++) {
+        days.push_back(20190103 + i % 9);
+        tickers.push_back(std::string(1, 'a' + i % 4));
+    }
+    composite_join_key<long, std::string> key(dates.size(), days.size());
+    key.add_column(dates.data(), days.data()).add_column(syms.data(), tickers.data());
+    BOOST_CHECK_EQUAL(key.size(), 2);
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        join_pairs expected;
+        std::vector<char> matched(days.size(), 0);
+        for (size_t i = 0; i < dates.size(); i++) {
+            bool hit = false;
+            for (size_t j = 0; j < days.size(); j++) {
+                if (dates[i] != days[j] || syms[i] != tickers[j]) continue;
+                expected.left.push_back(i);
+                expected.right.push_back(j);
+                matched[j] = hit = true;
+            }
+            if (!hit && (kind == join_kind::left || kind == join_kind::full)) {
+                expected.left.push_back(i);
+                expected.right.push_back(null_row);
+            }
+        }
+        for (size_t j = 0; j < days.size() && (kind == join_kind::right || kind == join_kind::full); j++) {
+            if (matched[j]) continue;
+            expected.left.push_back(null_row);
+            expected.right.push_back(j);
+        }
+        auto pairs = hash_join(key, kind);
+        BOOST_CHECK(pairs.left == expected.left && pairs.right == expected.right);
+    }
+    using type_collection1 = type_list<long, std::string, double>::types;
+    using type_collection2 = type_list<long, std::string, int>::types;
+    data_frame df1 = type_collection1{};
+    data_frame df2 = type_collection2{};
+    df1.add_column("date", std::vector<long>{1, 1, 2, 3});
+    df1.add_column("sym", std::vector<std::string>{"a", "b", "a", "a"});
+    df1.add_column("px", std::vector<double>{1.5, 2.5, 3.5, 4.5});
+    df2.add_column("day", std::vector<long>{1, 2, 2, 4});
+    df2.add_column("ticker", std::vector<std::string>{"a", "a", "b", "a"});
+    df2.add_column("qty", std::vector<int>{10, 20, 30, 40});
+    auto inner = combine_inner(df1, df2, {"date", "sym"}, {"day", "ticker"},
+        std::tuple<long, std::string, double>{}, {"date", "sym", "px"}, std::tuple<long, std::string, int>{}, {"day", "ticker", "qty"});
+    BOOST_CHECK_EQUAL(inner->get_cur_rows(), 2);
+    BOOST_CHECK_EQUAL(inner->get_c<int>("qty", 1), 20);
+    auto full = combine_full(df1, df2, {"date", "sym"}, {"day", "ticker"},
+        std::tuple<long, std::string, double>{}, {"date", "sym", "px"}, std::tuple<long, std::string, int>{}, {"day", "ticker", "qty"});
+    BOOST_CHECK_EQUAL(full->get_cur_rows(), 6);
+    // keys of the missing side are filled from the other side
+    BOOST_CHECK_EQUAL(full->get_c<long>("day", 1), 1);
+    BOOST_CHECK_EQUAL(full->get_c<std::string>("ticker", 1), "b");
+    BOOST_CHECK_EQUAL(full->get_c<int>("qty", 1), 0);
+    BOOST_CHECK_EQUAL(full->get_c<long>("date", 4), 2);
+    BOOST_CHECK_EQUAL(full->get_c<std::string>("sym", 4), "b");
+    auto right = combine_right(df1, df2, {"date", "sym"}, {"day", "ticker"},
+        std::tuple<long, std::string, double>{}, {"date", "sym", "px"}, std::tuple<long, std::string, int>{}, {"day", "ticker", "qty"});
+    BOOST_CHECK_EQUAL(right->get_cur_rows(), 4);
+    // a missing key or one of another type on the other side pairs nothing instead of dropping the column
+    BOOST_CHECK_EQUAL(join_frame_pairs(df1, df2, {"date", "missing"}, {"day", "ticker"}, join_kind::full).size(), 0);
+    BOOST_CHECK_EQUAL(join_frame_pairs(df1, df2, {"date", "px"}, {"day", "qty"}, join_kind::inner).size(), 0);
+    BOOST_CHECK_EQUAL(join_frame_pairs(df1, df2, {"date"}, {"day", "ticker"}, join_kind::inner).size(), 0);
+    BOOST_CHECK_EQUAL(join_view(df1, df2, std::vector<std::string>{}, {}).get_cur_rows(), 0);
+}
+BOOST_AUTO_TEST_CASE(data_frame_join_view) {
+    using type_collection1 = type_list<long, std::string, double>::types;
+    using type_collection2 = type_list<long, std::string, int>::types;
+    data_frame df1 = type_collection1{};
+    data_frame df2 = type_collection2{};
+    df1.add_column("id", std::vector<long>{3, 1, 2, 5});
+    df1.add_column("sym", std::vector<std::string>{"c", "a", "b", "e"});
+    df1.add_column("px", std::vector<double>{3.5, 1.5, 2.5, 5.5});
+    df2.add_column("id", std::vector<long>{2, 3, 3, 4});
+    df2.add_column("venue", std::vector<std::string>{"x", "y", "z", "w"});
+    df2.add_column("qty", std::vector<int>{20, 30, 31, 40});
+    auto view = join_view<long>(df1, df2, "id", join_kind::full);
+    BOOST_CHECK_EQUAL(view.get_cur_rows(), 6);
+    // a key column missing on either side pairs nothing
+    BOOST_CHECK_EQUAL(join_frame_pairs<long>(df1, df2, "missing", join_kind::full).size(), 0);
+    BOOST_CHECK_EQUAL(join_view<long>(df1, df2, "missing", join_kind::full).get_cur_rows(), 0);
+    BOOST_CHECK_EQUAL(join_view<std::string>(df1, df2, "sym", join_kind::left).get_cur_rows(), 0);
+    auto none = combine_full<long>(df1, df2, "missing", std::tuple<long, double>{}, {"id", "px"}, std::tuple<long, int>{}, {"id", "qty"});
+    BOOST_CHECK_EQUAL(std::max<row_id_t>(none->get_cur_rows(), 0), 0);
+    BOOST_CHECK_EQUAL(view.left_row(0), 0);
+    BOOST_CHECK_EQUAL(view.right_row(1), 2);
+    BOOST_CHECK_EQUAL(view.right_row(2), null_row);
+    auto qty = view.right_column<int>("qty");
+    BOOST_CHECK(qty == std::vector<int>({30, 31, 0, 20, 0, 40}));
+    // the key of a missing side comes from the other side
+    auto ids = view.left_column<long>("id");
+    BOOST_CHECK(ids == std::vector<long>({3, 3, 1, 2, 5, 4}));
+    BOOST_CHECK(view.left_column<int>("px").empty());
+    auto projected = view.to_data_frame(std::tuple<long, double>{}, {"id", "px"}, std::tuple<long, std::string>{}, {"id", "venue"});
+    auto eager = combine_full<long>(df1, df2, "id", std::tuple<long, double>{}, {"id", "px"}, std::tuple<long, std::string>{}, {"id", "venue"});
+    BOOST_CHECK_EQUAL(projected->get_cur_cols(), 3);
+    BOOST_CHECK_EQUAL(projected->get_cur_rows(), eager->get_cur_rows());
+    bool same = true;
+    for (row_id_t i = 0; i < eager->get_cur_rows(); i++)
+        same = same && projected->get_c<long>("id", i) == eager->get_c<long>("id", i)
+            && projected->get_c<double>("px", i) == eager->get_c<double>("px", i)
+            && projected->get_c<std::string>("venue", i) == eager->get_c<std::string>("venue", i);
+    BOOST_CHECK(same);
+    df2.add_column("day", std::vector<long>{2, 3, 3, 4});
+    auto composite = join_view(df1, df2, {"id", "sym"}, {"day", "venue"}, join_kind::left);
+    BOOST_CHECK_EQUAL(composite.get_cur_rows(), 4);
+    BOOST_CHECK(composite.right_column<long>("day") == std::vector<long>({3, 1, 2, 5}));
+    BOOST_CHECK(composite.right_column<std::string>("venue") == std::vector<std::string>({"c", "a", "b", "e"}));
+}
+BOOST_AUTO_TEST_CASE(data_frame_semi_anti_join) {
+    std::vector<long> present, missing;
+    for (long i = 0; i < 10000; i++) {
+        present.push_back(i * 2);
+        missing.push_back(i * 2 + 1);
+    }
+    join_key_set<long> keys(present.data(), present.size());
+    BOOST_CHECK_EQUAL(keys.size(), present.size());
+    bloom_filter filter(present.size());
+    for (long v: present) filter.insert(detail::hash_key(v));
+    size_t passed = 0;
+    bool all_found = true;
+    for (size_t i = 0; i < present.size(); i++) {
+        all_found = all_found && filter.may_contain(detail::hash_key(present[i])) && keys.contains(present[i]);
+        passed += filter.may_contain(detail::hash_key(missing[i]));
+        all_found = all_found && !keys.contains(missing[i]);
+    }
+    BOOST_CHECK(all_found);
+    BOOST_CHECK_LT(passed, missing.size() / 20);
+    using type_collection1 = type_list<long, double>::types;
+    using type_collection2 = type_list<long, std::string>::types;
+    data_frame df1 = type_collection1{};
+    data_frame df2 = type_collection2{};
+    df1.add_column("id", std::vector<long>{5, 1, 3, 3, 8, 2});
+    df1.add_column("px", std::vector<double>{0.5, 1.5, 2.5, 3.5, 4.5, 5.5});
+    df2.add_column("id", std::vector<long>{3, 3, 2, 9});
+    df2.add_column("name", std::vector<std::string>{"c", "c", "b", "i"});
+    auto semi = semi_join<long>(df1, df2, "id");
+    BOOST_CHECK(semi.get_selection().to_vector() == std::vector<row_id_t>({2, 3, 5}));
+    auto anti = anti_join<long>(df1, df2, "id");
+    BOOST_CHECK(anti.get_selection().to_vector() == std::vector<row_id_t>({0, 1, 4}));
+    auto chained = df1.select(semi_join_filter<long>("id", df2, "id") && col<double>("px") > 3.0);
+    BOOST_CHECK(chained.get_selection().to_vector() == std::vector<row_id_t>({3, 5}));
+    thread_pool pool(4);
+    auto parallel = df1.parallel_select(anti_join_filter<long>("id", df2, "id"), pool);
+    BOOST_CHECK(parallel.get_selection().to_vector() == std::vector<row_id_t>({0, 1, 4}));
+    auto narrowed = df1.select(col<double>("px") < 4.0).select(anti_join_filter<long>("id", df2, "id"));
+    BOOST_CHECK(narrowed.get_selection().to_vector() == std::vector<row_id_t>({0, 1}));
+}
+BOOST_AUTO_TEST_CASE(data_frame_asof_band_join) {
+    std::vector<long> trade_ts, quote_ts;
+    std::vector<std::string> trade_sym, quote_sym;
+    std::vector<double> bid;
+    for (int i = 0; i < 400; i++) {
+        trade_ts.push_back((i * 37) % 1000);
+        trade_sym.push_back(i % 3 ? "a" : "b");
+    }
+    for (int i = 0; i < 300; i++) {
+        quote_ts.push_back(i * 3 + i % 2);
+        quote_sym.push_back(i % 4 ? "a" : "c");
+        bid.push_back(i);
+    }
+    using type_collection1 = type_list<long, std::string>::types;
+    using type_collection2 = type_list<long, std::string, double>::types;
+    data_frame trades = type_collection1{};
+    data_frame quotes = type_collection2{};
+    trades.add_column("ts", trade_ts);
+    trades.add_column("sym", trade_sym);
+    quotes.add_column("ts", quote_ts);
+    quotes.add_column("sym", quote_sym);
+    quotes.add_column("bid", bid);
+    BOOST_CHECK(trades.get_sort_order("ts") == sort_order::none);
+    BOOST_CHECK(quotes.get_sort_order("ts") == sort_order::ascending);
+    // brute force: the last (first) quote at or before (after) the trade, within tolerance and symbol
+    auto nearest = [&](size_t i, asof_direction direction, bool by, long tolerance) {
+        row_id_t best = null_row;
+        for (size_t j = 0; j < quote_ts.size(); j++) {
+            if (by && trade_sym[i] != quote_sym[j]) continue;
+            long d = direction == asof_direction::backward ? trade_ts[i] - quote_ts[j] : quote_ts[j] - trade_ts[i];
+            if (d < 0 || d > tolerance) continue;
+            long best_d = best == null_row ? 0 : (direction == asof_direction::backward ? trade_ts[i] - quote_ts[best] : quote_ts[best] - trade_ts[i]);
+            if (best == null_row || d < best_d || (d == best_d && direction == asof_direction::backward)) best = j;
+        }
+        return best;
+    };
+    for (auto direction: {asof_direction::backward, asof_direction::forward}) {
+        for (bool by: {false, true}) {
+            asof_options<long> options;
+            options.direction = direction;
+            if (by) options.by = "sym";
+            auto view = asof_join(trades, quotes, "ts", options);
+            options.tolerance = 2;
+            auto close = asof_join(trades, quotes, "ts", options);
+            BOOST_CHECK_EQUAL(view.get_cur_rows(), trade_ts.size());
+            bool same = true;
+            for (size_t i = 0; i < trade_ts.size(); i++) {
+                same = same && view.left_row(i) == row_id_t(i) && view.right_row(i) == nearest(i, direction, by, 1000);
+                same = same && close.right_row(i) == nearest(i, direction, by, 2);
+            }
+            BOOST_CHECK(same);
+        }
+    }
+    asof_options<long> by_sym;
+    by_sym.by = "sym";
+    auto quote_syms = asof_join(trades, quotes, "ts", by_sym).right_column<std::string>("sym");
+    BOOST_CHECK(quote_syms == trade_sym);
+    // a by column missing on one side gives an empty view rather than ignoring it
+    asof_options<long> by_bid;
+    by_bid.by = "bid";
+    BOOST_CHECK_EQUAL(asof_join(trades, quotes, "ts", by_bid).get_cur_rows(), 0);
+    BOOST_CHECK_EQUAL(asof_join<long>(trades, quotes, "missing").get_cur_rows(), 0);
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        join_pairs expected;
+        std::vector<char> matched(quote_ts.size(), 0);
+        for (size_t i = 0; i < trade_ts.size(); i++) {
+            bool hit = false;
+            for (size_t j = 0; j < quote_ts.size(); j++) {
+                if (std::abs(trade_ts[i] - quote_ts[j]) > 1) continue;
+                expected.left.push_back(i);
+                expected.right.push_back(j);
+                matched[j] = hit = true;
+            }
+            if (!hit && (kind == join_kind::left || kind == join_kind::full)) {
+                expected.left.push_back(i);
+                expected.right.push_back(null_row);
+            }
+        }
+        for (size_t j = 0; j < quote_ts.size() && (kind == join_kind::right || kind == join_kind::full); j++) {
+            if (matched[j]) continue;
+            expected.left.push_back(null_row);
+            expected.right.push_back(j);
+        }
+        auto band = band_join(trades, quotes, "ts", 1L, kind);
+        BOOST_CHECK(band.get_pairs().left == expected.left && band.get_pairs().right == expected.right);
+    }
+    std::vector<long> sorted_ts(trade_ts);
+    std::sort(sorted_ts.begin(), sorted_ts.end());
+    auto merged = band_merge(sorted_ts.data(), sorted_ts.size(), quote_ts.data(), quote_ts.size(), 1L, join_kind::inner);
+    auto unsorted = band_join(trades, quotes, "ts", 1L);
+    BOOST_CHECK_EQUAL(merged.size(), unsorted.get_cur_rows());
+    // a key column missing on one side gives an empty view
+    BOOST_CHECK_EQUAL(band_join(trades, quotes, "missing", 1L, join_kind::full).get_cur_rows(), 0);
+    // a NaN right key is never matched and doesn't hide the other keys
+    using type_collection3 = type_list<double>::types;
+    data_frame left_ts = type_collection3{};
+    data_frame right_ts = type_collection3{};
+    left_ts.add_column("ts", std::vector<double>{1, 5});
+    right_ts.add_column("ts", std::vector<double>{6, std::numeric_limits<double>::quiet_NaN(), 2});
+    asof_options<double> forward;
+    forward.direction = asof_direction::forward;
+    auto ahead = asof_join(left_ts, right_ts, "ts", forward);
+    BOOST_CHECK(ahead.get_pairs().right == std::vector<row_id_t>({2, 0}));
+    auto behind = asof_join(left_ts, right_ts, "ts", asof_options<double>{});
+    BOOST_CHECK(behind.get_pairs().right == std::vector<row_id_t>({null_row, 2}));
+}
 BOOST_AUTO_TEST_CASE(data_frame_set_operations) {
     using type_collection2 = type_list<std::string, int, double>::types;
     data_frame df1 = type_collection2{};
@@ -298,4 +705,718 @@ BOOST_AUTO_TEST_CASE(data_frame_set_operations) {
     BOOST_CHECK_EQUAL(df5->get_cur_cols(), 3);
     df5->print_with_index({0, 1, 2, 3});
 }
+BOOST_AUTO_TEST_CASE(data_frame_hash_set_operations) {
+    using type_collection = type_list<long, std::string>::types;
+    data_frame df1 = type_collection{};
+    data_frame df2 = type_collection{};
+    df1.add_column("id", std::vector<long>{4, 1, 4, 2, 3, 1});
+    df1.add_column("sym", std::vector<std::string>{"d", "a", "d", "b", "x", "z"});
+    df2.add_column("id", std::vector<long>{3, 2, 5, 2, 4});
+    df2.add_column("sym", std::vector<std::string>{"c", "b", "e", "b", "d"});
+    auto rows = [](auto* df) {
+        std::vector<std::pair<long, std::string>> ans;
+        for (row_id_t i = 0; i < df->get_cur_rows(); i++)
+            ans.emplace_back(df->template get_c<long>("id", i), df->template get_c<std::string>("sym", i));
+        return ans;
+    };
+    using row_list = std::vector<std::pair<long, std::string>>;
+    auto both = rows(intersect(df1, df2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(both == row_list({{4, "d"}, {2, "b"}}));
+    auto either = rows(setdiff(df1, df2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(either == row_list({{1, "a"}, {3, "x"}, {1, "z"}, {3, "c"}, {5, "e"}}));
+    auto all = rows(setunion(df1, df2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(all == row_list({{4, "d"}, {1, "a"}, {2, "b"}, {3, "x"}, {1, "z"}, {3, "c"}, {5, "e"}}));
+    // on a subset of the columns
+    auto ids = intersect(df1, df2, std::tuple<long>{}, {"id"});
+    BOOST_CHECK_EQUAL(ids->get_cur_rows(), 3);
+    BOOST_CHECK_EQUAL(ids->get_cur_cols(), 1);
+    // a missing or mistyped column gives no frame
+    BOOST_CHECK(intersect(df1, df2, std::tuple<long>{}, {"missing"}) == nullptr);
+    BOOST_CHECK(setdiff(df1, df2, std::tuple<long, std::string>{}, {"id", "missing"}) == nullptr);
+    BOOST_CHECK(setunion(df1, df2, std::tuple<std::string>{}, {"id"}) == nullptr);
+    // NaN equals NaN, rows holding it are distinct once and found on the other side
+    using nan_collection = type_list<double, long>::types;
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    data_frame nan1 = nan_collection{};
+    data_frame nan2 = nan_collection{};
+    std::vector<double> px1(20000, nan), px2(10000, nan);
+    px1[3] = 1.0;
+    px2[5] = 2.0;
+    nan1.add_column("px", px1);
+    nan1.add_column("n", std::vector<long>(px1.size(), 7));
+    nan2.add_column("px", px2);
+    nan2.add_column("n", std::vector<long>(px2.size(), 7));
+    auto nan_both = intersect(nan1, nan2, std::tuple<double, long>{}, {"px", "n"});
+    BOOST_CHECK_EQUAL(nan_both->get_cur_rows(), 1);
+    BOOST_CHECK(std::isnan(nan_both->get_c<double>("px", 0)));
+    auto nan_either = setdiff(nan1, nan2, std::tuple<double>{}, {"px"});
+    BOOST_CHECK_EQUAL(nan_either->get_cur_rows(), 2);
+    BOOST_CHECK_EQUAL(nan_either->get_c<double>("px", 0), 1.0);
+    BOOST_CHECK_EQUAL(nan_either->get_c<double>("px", 1), 2.0);
+    BOOST_CHECK_EQUAL(setunion(nan1, nan2, std::tuple<double>{}, {"px"})->get_cur_rows(), 3);
+}
+BOOST_AUTO_TEST_CASE(data_frame_merge_set_operations) {
+    using type_collection = type_list<long, std::string>::types;
+    std::vector<long> id1{1, 1, 2, 2, 4, 4, 6}, id2{2, 3, 3, 4, 4, 5, 6};
+    std::vector<std::string> sym1{"a", "a", "b", "c", "d", "d", "f"}, sym2{"b", "c", "c", "d", "e", "e", "g"};
+    data_frame sorted1 = type_collection{};
+    data_frame sorted2 = type_collection{};
+    data_frame plain1 = type_collection{};
+    data_frame plain2 = type_collection{};
+    for (auto* df: {&sorted1, &plain1}) {
+        df->add_column("id", id1);
+        df->add_column("sym", sym1);
+    }
+    for (auto* df: {&sorted2, &plain2}) {
+        df->add_column("id", id2);
+        df->add_column("sym", sym2);
+    }
+    sorted1.declare_sorted("id", sort_order::ascending);
+    sorted2.declare_sorted("id", sort_order::ascending);
+    plain1.declare_sorted("id", sort_order::none);
+    plain2.declare_sorted("id", sort_order::none);
+    auto rows = [](auto* df) {
+        std::vector<std::pair<long, std::string>> ans;
+        for (row_id_t i = 0; i < df->get_cur_rows(); i++)
+            ans.emplace_back(df->template get_c<long>("id", i), df->template get_c<std::string>("sym", i));
+        return ans;
+    };
+    using row_list = std::vector<std::pair<long, std::string>>;
+    // the merge gives the same rows in the same order as hashing
+    auto both = rows(intersect(sorted1, sorted2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(both == row_list({{2, "b"}, {4, "d"}}));
+    BOOST_CHECK(both == rows(intersect(plain1, plain2, std::tuple<long, std::string>{}, {"id", "sym"})));
+    auto either = rows(setdiff(sorted1, sorted2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(either == rows(setdiff(plain1, plain2, std::tuple<long, std::string>{}, {"id", "sym"})));
+    auto all = rows(setunion(sorted1, sorted2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(all == rows(setunion(plain1, plain2, std::tuple<long, std::string>{}, {"id", "sym"})));
+    BOOST_CHECK_EQUAL(all.size(), 9);
+    // a frame sorted on its first column only is hashed
+    data_frame unsorted = type_collection{};
+    unsorted.add_column("id", std::vector<long>{2, 2, 4});
+    unsorted.add_column("sym", std::vector<std::string>{"c", "b", "d"});
+    unsorted.declare_sorted("id", sort_order::ascending);
+    auto mixed = rows(intersect(unsorted, sorted2, std::tuple<long, std::string>{}, {"id", "sym"}));
+    BOOST_CHECK(mixed == row_list({{2, "b"}, {4, "d"}}));
+    // streamed in chunks of two rows, the output is in key order
+    auto source = [&](const std::vector<long>& ids, const std::vector<std::string>& syms) {
+        return [&ids, &syms, first = size_t(0)](data_frame<long, std::string>& chunk) mutable {
+            if (first == ids.size()) return false;
+            size_t last = std::min(first + 2, ids.size());
+            chunk.add_column("id", std::vector<long>(ids.begin() + first, ids.begin() + last));
+            chunk.add_column("sym", std::vector<std::string>(syms.begin() + first, syms.begin() + last));
+            first = last;
+            return true;
+        };
+    };
+    row_list streamed;
+    size_t from_left = 0;
+    auto sink = [&](const data_frame<long, std::string>& chunk, row_id_t row, bool left) {
+        streamed.emplace_back(chunk.get_c<long>("id", row), chunk.get_c<std::string>("sym", row));
+        from_left += left;
+    };
+    bool ok = merge_set_operation<long, std::string>(set_operation::union_, {"id", "sym"}, source(id1, sym1),
+        source(id2, sym2), sink);
+    BOOST_CHECK(ok);
+    auto by_key = all;
+    std::sort(by_key.begin(), by_key.end());
+    BOOST_CHECK(streamed == by_key);
+    BOOST_CHECK_EQUAL(from_left, 5);
+    streamed.clear();
+    ok = merge_set_operation<long, std::string>(set_operation::intersect, {"id", "sym"}, source(id1, sym1),
+        source(id2, sym2), sink);
+    BOOST_CHECK(ok);
+    BOOST_CHECK(streamed == both);
+    streamed.clear();
+    ok = merge_set_operation<long, std::string>(set_operation::union_, {"id", "missing"}, source(id1, sym1),
+        source(id2, sym2), sink);
+    BOOST_CHECK(!ok);
+    // two files sorted by the external sorter are reconciled block by block
+    auto dir = std::filesystem::temp_directory_path() /
+        ("data_frame_merge_set_test_" + std::to_string(std::random_device{}()));
+    BOOST_REQUIRE(std::filesystem::create_directory(dir));
+    external_sort_options options;
+    options.temp_dir = dir.string();
+    options.block_rows = 3;
+    using sorter_t = external_sorter<long, std::string>;
+    auto write_sorted = [&](const std::vector<long>& ids, const std::vector<std::string>& syms, const std::string& name) {
+        sorter_t sorter({{"id"}, {"sym"}}, options);
+        data_frame chunk = type_collection{};
+        // pushed in reverse, the sorter puts them back in order
+        chunk.add_column("id", std::vector<long>(ids.rbegin(), ids.rend()));
+        chunk.add_column("sym", std::vector<std::string>(syms.rbegin(), syms.rend()));
+        std::string path = (dir / name).string();
+        BOOST_CHECK(sorter.push(chunk) && sorter.merge_to_file(path));
+        return path;
+    };
+    sorter_t::chunk_reader left_file(write_sorted(id1, sym1, "left.run"));
+    sorter_t::chunk_reader right_file(write_sorted(id2, sym2, "right.run"));
+    streamed.clear();
+    ok = merge_set_operation<long, std::string>(set_operation::union_, {"id", "sym"}, std::ref(left_file),
+        std::ref(right_file), sink);
+    BOOST_CHECK(ok && left_file.good() && right_file.good());
+    BOOST_CHECK(streamed == by_key);
+    std::filesystem::remove_all(dir);
+}
+BOOST_AUTO_TEST_CASE(data_frame_group_by) {
+    std::vector<std::string> sym;
+    std::vector<long> qty;
+    std::vector<double> px;
+    for (long i = 0; i < 50000; i++) {
+        sym.push_back("S" + std::to_string(i * 7919 % 101));
+        qty.push_back(i % 13 - 6);
+        px.push_back(i % 29 == 0 ? std::numeric_limits<double>::quiet_NaN() : (i * 31 % 997) / 8.0);
+    }
+    using type_collection = type_list<long, double, std::string>::types;
+    data_frame df = type_collection{};
+    df.add_column("sym", sym);
+    df.add_column("qty", qty);
+    df.add_column("px", px);
+    struct expected_group {
+        long qty_sum = 0, qty_first = 0;
+        double px_total = 0, px_min = 0, px_max = 0;
+        size_t rows = 0, prices = 0;
+    };
+    std::map<std::string, expected_group> expected;
+    std::vector<std::string> order;
+    for (size_t i = 0; i < sym.size(); i++) {
+        auto [iter, inserted] = expected.try_emplace(sym[i]);
+        auto& g = iter->second;
+        if (inserted) {
+            order.push_back(sym[i]);
+            g.qty_first = qty[i];
+        }
+        g.qty_sum += qty[i];
+        ++g.rows;
+        if (std::isnan(px[i])) continue;
+        g.px_min = g.prices ? std::min(g.px_min, px[i]) : px[i];
+        g.px_max = g.prices ? std::max(g.px_max, px[i]) : px[i];
+        g.px_total += px[i];
+        ++g.prices;
+    }
+    thread_pool pool(4);
+    auto grouped = df.group_by({"sym"}, pool);
+    BOOST_CHECK_EQUAL(grouped.groups(), 101);
+    std::unique_ptr<data_frame<long, double, std::string, std::size_t>> out(grouped.agg({sum("qty"), mean("px"),
+        count(), count("px").as("priced"), min("px"), max("px"), first("qty")}));
+    BOOST_REQUIRE(out);
+    BOOST_CHECK_EQUAL(out->get_cur_rows(), 101);
+    BOOST_CHECK_EQUAL(out->get_cur_cols(), 8);
+    for (row_id_t r = 0; r < out->get_cur_rows(); r++) {
+        // groups come in first-seen order
+        const std::string& key = out->get_c<std::string>("sym", r);
+        BOOST_CHECK_EQUAL(key, order[r]);
+        const auto& g = expected[key];
+        BOOST_CHECK_EQUAL(out->get_c<long>("qty_sum", r), g.qty_sum);
+        BOOST_CHECK_CLOSE(out->get_c<double>("px_mean", r), g.px_total / g.prices, 1e-9);
+        BOOST_CHECK_EQUAL(out->get_c<std::size_t>("count", r), g.rows);
+        BOOST_CHECK_EQUAL(out->get_c<std::size_t>("priced", r), g.prices);
+        BOOST_CHECK_EQUAL(out->get_c<double>("px_min", r), g.px_min);
+        BOOST_CHECK_EQUAL(out->get_c<double>("px_max", r), g.px_max);
+        BOOST_CHECK_EQUAL(out->get_c<long>("qty_first", r), g.qty_first);
+    }
+    // several keys, NaN keys belong to no group, no key is one group
+    std::unique_ptr<data_frame<long, double, std::string, std::size_t>> by_price(df.group_by({"px", "sym"}).agg({count()}));
+    BOOST_REQUIRE(by_price);
+    size_t priced = 0;
+    for (row_id_t r = 0; r < by_price->get_cur_rows(); r++) priced += by_price->get_c<std::size_t>("count", r);
+    BOOST_CHECK_EQUAL(priced, 50000 - 50000 / 29 - 1);
+    std::unique_ptr<data_frame<long, double, std::string, std::size_t>> total(df.group_by({}).agg({sum("qty"), count()}));
+    BOOST_REQUIRE(total);
+    BOOST_CHECK_EQUAL(total->get_cur_rows(), 1);
+    BOOST_CHECK_EQUAL(total->get_c<long>("qty_sum", 0), std::accumulate(qty.begin(), qty.end(), 0L));
+    BOOST_CHECK_EQUAL(total->get_c<std::size_t>("count", 0), 50000);
+    // integer sums are written in 64 bits and don't overflow the column type
+    data_frame narrow = type_list<int, unsigned short>::types{};
+    narrow.add_column("big", std::vector<int>(4, std::numeric_limits<int>::max()));
+    narrow.add_column("small", std::vector<unsigned short>(4, std::numeric_limits<unsigned short>::max()));
+    std::unique_ptr<data_frame<int, unsigned short, double, std::size_t, std::int64_t>> sums(narrow.group_by({}).agg({sum("big"), sum("small"), max("big")}));
+    BOOST_REQUIRE(sums);
+    BOOST_CHECK_EQUAL(sums->get_c<std::int64_t>("big_sum", 0), 4 * std::int64_t(std::numeric_limits<int>::max()));
+    BOOST_CHECK_EQUAL(sums->get_c<std::uint64_t>("small_sum", 0), 4 * std::uint64_t(std::numeric_limits<unsigned short>::max()));
+    BOOST_CHECK_EQUAL(sums->get_c<int>("big_max", 0), std::numeric_limits<int>::max());
+    // missing columns, functions that don't apply and repeated names give nothing
+    BOOST_CHECK(!df.group_by({"missing"}).agg({count()}));
+    BOOST_CHECK(!df.group_by({"sym"}).agg({sum("missing")}));
+    BOOST_CHECK(!df.group_by({"qty"}).agg({mean("sym")}));
+    BOOST_CHECK(!df.group_by({"sym"}).agg({count(), count("px").as("count")}));
+}
+BOOST_AUTO_TEST_CASE(data_frame_drop_duplicates) {
+    std::vector<long> account;
+    std::vector<std::string> currency;
+    std::vector<double> amount;
+    for (long i = 0; i < 100000; i++) {
+        account.push_back((i * 7919) % 5003);
+        currency.push_back(i % 3 ? "usd" : "eur");
+        amount.push_back(i % 11);
+    }
+    using type_collection = type_list<long, std::string, double>::types;
+    data_frame df = type_collection{};
+    df.add_column("account", account);
+    df.add_column("currency", currency);
+    df.add_column("amount", amount);
+    std::map<std::pair<long, std::string>, std::pair<row_id_t, row_id_t>> seen;
+    for (size_t i = 0; i < account.size(); i++) {
+        auto iter = seen.try_emplace({account[i], currency[i]}, row_id_t(i), row_id_t(i)).first;
+        iter->second.second = i;
+    }
+    std::vector<row_id_t> first, last;
+    for (const auto& s: seen) {
+        first.push_back(s.second.first);
+        last.push_back(s.second.second);
+    }
+    std::sort(first.begin(), first.end());
+    std::sort(last.begin(), last.end());
+    thread_pool serial(1), parallel(4);
+    BOOST_CHECK(df.unique_rows({"account", "currency"}, keep_duplicate::first, serial) == first);
+    BOOST_CHECK(df.unique_rows({"account", "currency"}, keep_duplicate::first, parallel) == first);
+    BOOST_CHECK(df.unique_rows({"account", "currency"}, keep_duplicate::last, parallel) == last);
+    auto view = df.drop_duplicates({"currency", "account"}, keep_duplicate::last, parallel);
+    BOOST_CHECK(view.get_selection().to_vector() == last);
+    BOOST_CHECK_EQUAL(df.distinct({"currency"}).get_cur_rows(), 2);
+    BOOST_CHECK_EQUAL(df.distinct().get_cur_rows(), df.distinct({"account", "currency", "amount"}).get_cur_rows());
+    BOOST_CHECK_EQUAL(df.distinct({"missing"}).get_cur_rows(), 0);
+    data_frame small = type_list<double>::types{};
+    small.add_column("x", std::vector<double>{1.0, std::numeric_limits<double>::quiet_NaN(), 1.0, std::numeric_limits<double>::quiet_NaN()});
+    // NaN equals NaN when deduplicating
+    BOOST_CHECK(small.unique_rows({"x"}, keep_duplicate::first) == std::vector<row_id_t>({0, 1}));
+    BOOST_CHECK(small.unique_rows({"x"}, keep_duplicate::last) == std::vector<row_id_t>({2, 3}));
+    data_frame nans = type_list<double, long>::types{};
+    std::vector<double> nan_vec(50000, std::numeric_limits<double>::quiet_NaN());
+    std::vector<long> parity_vec;
+    for (int i = 0; i < 50000; i++) parity_vec.push_back(i % 2);
+    nan_vec[10] = 1.5;
+    nans.add_column("x", nan_vec);
+    nans.add_column("parity", parity_vec);
+    BOOST_CHECK(nans.unique_rows({"x"}, keep_duplicate::first, parallel) == std::vector<row_id_t>({0, 10}));
+    BOOST_CHECK(nans.unique_rows({"x", "parity"}, keep_duplicate::last, serial) == std::vector<row_id_t>({10, 49998, 49999}));
+    BOOST_CHECK_EQUAL(nans.drop_duplicates({"x"}, keep_duplicate::first, parallel).get_cur_rows(), 2);
+}
+BOOST_AUTO_TEST_CASE(data_frame_zone_map_select) {
+    using type_collection = type_list<long, double>::types;
+    data_frame df(type_collection{});
+    std::vector<long> ts;
+    std::vector<double> px;
+    for (long i = 0; i < 100000; i++) {
+        ts.push_back(1000 + i);
+        px.push_back(i % 5000 == 7 ? std::nan("") : i / 100.0);
+    }
+    df.add_column("ts", ts);
+    df.add_column("px", px);
+    const auto* zones = df.get_zone_map<long>("ts");
+    BOOST_REQUIRE(zones != nullptr);
+    BOOST_CHECK_EQUAL(zones->block_count(), (100000 + zone_map_block_rows - 1) / zone_map_block_rows);
+    BOOST_CHECK_EQUAL(zones->mins[0], 1000);
+    BOOST_CHECK_EQUAL(zones->maxs[0], 1000 + long(zone_map_block_rows) - 1);
+    BOOST_CHECK(df.get_zone_map<long>("missing") == nullptr);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", between(50000L, 50999L)).get_cur_rows(), 1000);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", lt(1010L)).get_cur_rows(), 10);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", ge(1000L)).get_cur_rows(), 100000);
+    BOOST_CHECK_EQUAL(df.select(col<long>("ts") > 100990L && col<double>("px") >= 0.0).get_cur_rows(), 9);
+    // blocks containing NaN are never assumed to match entirely
+    BOOST_CHECK_EQUAL(df.select<double>("px", ge(0.0)).get_cur_rows(), 100000 - 20);
+    // reads leave the column version alone, so selects in a row reuse the same statistics
+    size_t built_version = zones->version;
+    BOOST_CHECK_EQUAL(df.select<long>("ts", lt(1010L)).get_cur_rows(), 10);
+    BOOST_CHECK_EQUAL(df.get_c<long>("ts", 5), 1005);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", gt(100990L)).get_cur_rows(), 9);
+    BOOST_CHECK(df.get_zone_map<long>("ts") == zones);
+    BOOST_CHECK_EQUAL(zones->version, built_version);
+    // apply_with_index changes the column, the statistics are rebuilt before the next select
+    df.apply_with_index({0, 1}, [](auto& t) {
+        return t * 1000;
+    });
+    BOOST_CHECK_EQUAL(df.select<long>("ts", gt(500000L)).get_cur_rows(), 2);
+    BOOST_CHECK_EQUAL(df.get_zone_map<long>("ts")->maxs[0], 1001000);
+    df.get<long>("ts", 99999) = -5;
+    BOOST_CHECK_EQUAL(df.select<long>("ts", lt(0L)).get_cur_rows(), 1);
+}
+BOOST_AUTO_TEST_CASE(data_frame_secondary_index) {
+    using type_collection = type_list<long, double, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<long> id_vec;
+    std::vector<double> px_vec;
+    std::vector<std::string> sym_vec;
+    for (long i = 0; i < 3000; i++) {
+        id_vec.push_back(i * 7 % 1000);
+        px_vec.push_back(i / 10.0);
+        sym_vec.push_back("sym" + std::to_string(i % 20));
+    }
+    df.add_column("id", id_vec);
+    df.add_column("px", px_vec);
+    df.add_column("sym", sym_vec);
+    BOOST_CHECK(df.get_index<long>("id") == nullptr);
+    BOOST_CHECK(!df.create_index<long>("missing"));
+    auto scan_eq = df.select<long>("id", [](long v) { return v == 14; }).get_cur_rows();
+    auto scan_range = df.select<double>("px", [](double v) { return v >= 10.0 && v <= 20.0; }).get_cur_rows();
+    BOOST_CHECK(df.create_index<long>("id", index_kind::hash));
+    BOOST_CHECK(df.create_index<double>("px", index_kind::sorted));
+    BOOST_CHECK(df.create_index<std::string>("sym"));
+    BOOST_CHECK_EQUAL(df.get_index<long>("id")->count(14), 3);
+    BOOST_CHECK_EQUAL(df.select<long>("id", eq(14L)).get_cur_rows(), scan_eq);
+    BOOST_CHECK_EQUAL(df.select<long>("id", in({14L, 21L, 5000L})).get_cur_rows(), 6);
+    BOOST_CHECK_EQUAL(df.select<double>("px", between(10.0, 20.0)).get_cur_rows(), scan_range);
+    BOOST_CHECK_EQUAL(df.select<double>("px", lt(1.0)).get_cur_rows(), 10);
+    BOOST_CHECK_EQUAL(df.select<std::string>("sym", eq("sym3"s)).get_cur_rows(), 150);
+    // hash indexes don't answer ranges, select falls back to scanning
+    BOOST_CHECK_EQUAL(df.select<long>("id", lt(10L)).get_cur_rows(), 30);
+    auto rows = df.get_index<long>("id")->lookup(eq(14L));
+    BOOST_CHECK(std::is_sorted(rows.begin(), rows.end()));
+    // the index follows updates of the column
+    df.apply_with_index({2}, [](auto& t) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(t)>, long>) return t + 1;
+        else return t;
+    });
+    BOOST_CHECK_EQUAL(df.select<long>("id", eq(14L)).get_cur_rows(), 2);
+    BOOST_CHECK_EQUAL(df.select<long>("id", eq(15L)).get_cur_rows(), 4);
+    // joins reuse the index on the left side
+    using type_collection2 = type_list<long, int>::types;
+    data_frame df2(type_collection2{});
+    df2.from_tuples(std::vector{std::make_tuple(14L, 1), std::make_tuple(15L, 2), std::make_tuple(-1L, 3)}, {"id", "int_vec"});
+    auto joined = combine_inner<long>(df, df2, "id", 
+                                    std::tuple<long, double>{}, {"id", "px"},
+                                    std::tuple<long, int>{}, {"id", "int_vec"});
+    BOOST_CHECK_EQUAL(joined->get_cur_rows(), 6);
+    // probing the index of either side pairs rows like a hash join
+    const auto& ids = *df.get_column<long>("id");
+    const auto& ids2 = *df2.get_column<long>("id");
+    for (auto kind: {join_kind::inner, join_kind::left, join_kind::right, join_kind::full}) {
+        auto lhs = join_frame_pairs<long>(df, df2, "id", kind);
+        auto rhs = join_frame_pairs<long>(df2, df, "id", kind);
+        auto by_index = index_join(&ids[0], ids.size(), &ids2[0], ids2.size(), *df.get_index<long>("id"), false, kind);
+        auto lhs_hash = hash_join(column_join_key<long>(&ids[0], ids.size(), &ids2[0], ids2.size()), kind);
+        auto rhs_hash = hash_join(column_join_key<long>(&ids2[0], ids2.size(), &ids[0], ids.size()), kind);
+        BOOST_CHECK(lhs.left == by_index.left && lhs.right == by_index.right);
+        BOOST_CHECK(lhs.left == lhs_hash.left && lhs.right == lhs_hash.right);
+        BOOST_CHECK(rhs.left == rhs_hash.left && rhs.right == rhs_hash.right);
+    }
+    BOOST_CHECK(df.drop_index<long>("id"));
+    auto joined2 = df.combine_left<long>(df2, "id", 
+                                    std::tuple<long, double>{}, {"id", "px"},
+                                    std::tuple<long, int>{}, {"id", "int_vec"});
+    BOOST_CHECK_EQUAL(joined2.get_cur_rows(), 3000);
+    // NaN rows are left out of both kinds of index
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    std::vector<double> with_nan{1, nan, 2, nan, 1};
+    for (auto kind: {index_kind::hash, index_kind::sorted}) {
+        column_index<double> index(kind);
+        index.build(with_nan.data(), with_nan.size(), 0);
+        auto twos = index.equal_rows(2.0);
+        BOOST_CHECK(std::vector<row_id_t>(twos.first, twos.second) == std::vector<row_id_t>{2});
+        BOOST_CHECK_EQUAL(index.count(1.0), 2);
+        BOOST_CHECK_EQUAL(index.count(nan), 0);
+    }
+    column_index<double> sorted_nan(index_kind::sorted);
+    sorted_nan.build(with_nan.data(), with_nan.size(), 0);
+    BOOST_CHECK(sorted_nan.lookup(ge(0.0)) == std::vector<row_id_t>({0, 2, 4}));
+}
+BOOST_AUTO_TEST_CASE(data_frame_bitmap_index) {
+    using type_collection = type_list<long, double, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<long> venue_vec;
+    std::vector<double> px_vec;
+    std::vector<std::string> side_vec;
+    // spans several 65536-row chunks with both sparse and dense bitmaps
+    for (long i = 0; i < 200000; i++) {
+        venue_vec.push_back(i % 7 == 0 ? 9 : i % 3);
+        px_vec.push_back(i % 100);
+        side_vec.push_back(i % 5 == 0 ? "sell" : "buy");
+    }
+    df.add_column("venue", venue_vec);
+    df.add_column("px", px_vec);
+    df.add_column("side", side_vec);
+    auto e = col<std::string>("side") == "sell"s && (col<long>("venue").in({1L, 9L}) || col<long>("venue") == 2L);
+    auto expected = df.mask(e).to_index();
+    size_t expected_venue = df.mask<long>("venue", eq(9L)).count();
+    BOOST_CHECK(!e.bitmap(df));
+    BOOST_CHECK(df.create_index<long>("venue", index_kind::bitmap));
+    BOOST_CHECK(df.create_index<std::string>("side", index_kind::bitmap));
+    BOOST_CHECK_EQUAL(df.get_bitmap_index<long>("venue")->distinct(), 4);
+    BOOST_CHECK(df.get_index<long>("venue") == nullptr);
+    auto rows = e.bitmap(df);
+    BOOST_REQUIRE(rows);
+    BOOST_CHECK(rows->to_index() == expected);
+    BOOST_CHECK_EQUAL(df.count(e), expected.size());
+    BOOST_CHECK_EQUAL(df.select(e).get_cur_rows(), expected.size());
+    BOOST_CHECK_EQUAL(df.count<long>("venue", eq(9L)), expected_venue);
+    BOOST_CHECK_EQUAL(df.count<long>("venue", ge(1L)), df.mask<long>("venue", ge(1L)).count());
+    BOOST_CHECK_EQUAL(df.select<long>("venue", eq(9L)).get_cur_rows(), expected_venue);
+    // a condition on a column without a bitmap index falls back to scanning
+    auto e2 = col<std::string>("side") == "buy"s && col<double>("px") < 10.0;
+    BOOST_CHECK(!e2.bitmap(df));
+    BOOST_CHECK_EQUAL(df.count(e2), df.mask(e2).count());
+    BOOST_CHECK_EQUAL(df.count(!(col<long>("venue") == 9L)), 200000 - expected_venue);
+    // the bitmaps follow updates of the column
+    df.apply_with_index({1}, [](auto& t) {
+        if constexpr (std::is_same_v<std::decay_t<decltype(t)>, long>) return 9L;
+        else return t;
+    });
+    BOOST_CHECK_EQUAL(df.count<long>("venue", eq(9L)), expected_venue + 1);
+    BOOST_CHECK(df.drop_index<long>("venue"));
+    BOOST_CHECK(df.get_bitmap_index<long>("venue") == nullptr);
+}
+BOOST_AUTO_TEST_CASE(data_frame_parallel_order) {
+    using type_collection = type_list<long, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<long> key_vec;
+    std::vector<std::string> str_vec;
+    for (long i = 0; i < 100003; i++) {
+        key_vec.push_back(i * 7919 % 1009);
+        str_vec.push_back(std::to_string(i % 211));
+    }
+    df.add_column("key", key_vec);
+    df.add_column("str", str_vec);
+    std::vector<row_id_t> expected(key_vec.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), [&](row_id_t l, row_id_t r) { return key_vec[l] > key_vec[r]; });
+    thread_pool single(1), pool(4), odd(3);
+    BOOST_CHECK(df.order<long>("key", single) == expected);
+    BOOST_CHECK(df.order<long>("key", pool) == expected);
+    BOOST_CHECK(df.order<long>("key", odd) == expected);
+    BOOST_CHECK(df.order<long>("key") == expected);
+    auto by_str = df.order<std::string>("str", [](const std::string& l, const std::string& r) { return l < r; }, pool);
+    BOOST_CHECK(by_str == df.order<std::string>("str", [](const std::string& l, const std::string& r) { return l < r; }, single));
+    BOOST_CHECK(std::is_sorted(by_str.begin(), by_str.end(), [&](row_id_t l, row_id_t r) { return str_vec[l] < str_vec[r]; }));
+    BOOST_CHECK(df.order<long>("missing").empty());
+}
+BOOST_AUTO_TEST_CASE(data_frame_radix_order) {
+    using type_collection = type_list<long, double, int>::types;
+    data_frame df(type_collection{});
+    std::vector<long> ts_vec;
+    std::vector<double> px_vec;
+    std::vector<int> qty_vec;
+    for (long i = 0; i < 50000; i++) {
+        ts_vec.push_back((i * 2654435761L) % 1000003 - 500000 + (i % 3 ? 0 : (1L << 40)));
+        px_vec.push_back(((i * 7919) % 2001 - 1000) / 8.0);
+        qty_vec.push_back(i % 17 - 8);
+    }
+    px_vec[10] = -0.0;
+    px_vec[11] = std::numeric_limits<double>::infinity();
+    px_vec[12] = -std::numeric_limits<double>::infinity();
+    px_vec[13] = std::numeric_limits<double>::quiet_NaN();
+    df.add_column("ts", ts_vec);
+    df.add_column("px", px_vec);
+    df.add_column("qty", qty_vec);
+    thread_pool pool(4);
+    auto desc = [](const auto& l, const auto& r) { return l > r; };
+    BOOST_CHECK(df.order<long>("ts", pool) == parallel_argsort(ts_vec.data(), ts_vec.size(), desc, pool));
+    BOOST_CHECK(df.order<int>("qty") == parallel_argsort(qty_vec.data(), qty_vec.size(), desc, pool));
+    // NaN goes last, -0.0 ties with 0.0 and keeps its row order
+    auto px_order = df.order<double>("px", pool);
+    BOOST_CHECK_EQUAL(px_order.front(), 11);
+    BOOST_CHECK_EQUAL(px_order.back(), 13);
+    BOOST_CHECK_EQUAL(px_order[px_order.size() - 2], 12);
+    px_vec[13] = 0.0;
+    auto px_expected = parallel_argsort(px_vec.data(), px_vec.size(), desc, pool);
+    px_expected.erase(std::find(px_expected.begin(), px_expected.end(), 13));
+    px_order.pop_back();
+    BOOST_CHECK(px_order == px_expected);
+    auto asc = radix_argsort(ts_vec.data(), ts_vec.size(), false, pool);
+    BOOST_CHECK(std::is_sorted(asc.begin(), asc.end(), [&](row_id_t l, row_id_t r) { return ts_vec[l] < ts_vec[r]; }));
+    BOOST_CHECK_EQUAL(df.sort<long>("ts").get_cur_rows(), 50000);
+}
+BOOST_AUTO_TEST_CASE(data_frame_multi_key_sort) {
+    using type_collection = type_list<int, double, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<int> date_vec;
+    std::vector<std::string> region_vec;
+    std::vector<double> price_vec;
+    for (int i = 0; i < 40000; i++) {
+        date_vec.push_back(20200101 + i % 13);
+        region_vec.push_back(i % 5 == 0 ? std::string("eu\0x", 4) : (i % 5 == 1 ? "eu" : "us"));
+        price_vec.push_back(i % 11 == 0 ? std::numeric_limits<double>::quiet_NaN() : (i * 37 % 101) / 4.0);
+    }
+    df.add_column("date", date_vec);
+    df.add_column("region", region_vec);
+    df.add_column("price", price_vec);
+    thread_pool pool(4);
+    auto index = df.order_by({{"date"}, {"region"}, {"price", false}}, true, pool);
+    auto key_less = [&](row_id_t l, row_id_t r) {
+        if (date_vec[l] != date_vec[r]) return date_vec[l] < date_vec[r];
+        if (region_vec[l] != region_vec[r]) return region_vec[l] < region_vec[r];
+        bool ln = std::isnan(price_vec[l]), rn = std::isnan(price_vec[r]);
+        if (ln || rn) return !ln && rn;
+        return price_vec[l] > price_vec[r];
+    };
+    std::vector<row_id_t> expected(date_vec.size());
+    std::iota(expected.begin(), expected.end(), 0);
+    std::stable_sort(expected.begin(), expected.end(), key_less);
+    BOOST_CHECK(index == expected);
+    auto unstable = df.order_by({{"date"}, {"region"}, {"price", false}}, false, pool);
+    BOOST_CHECK(std::is_sorted(unstable.begin(), unstable.end(), key_less));
+    // nulls first, and a fixed-width key short enough to be radix sorted
+    auto nulls_first = df.order_by({{"price", true, null_order::first}, {"date", false}}, true, pool);
+    BOOST_CHECK(std::isnan(price_vec[nulls_first.front()]));
+    BOOST_CHECK(!std::isnan(price_vec[nulls_first.back()]));
+    auto by_date = df.order_by({{"date", false}});
+    BOOST_CHECK(by_date == df.order<int>("date"));
+    BOOST_CHECK_EQUAL(df.sort_by({{"region"}, {"date"}}).get_cur_rows(), 40000);
+    BOOST_CHECK(df.order_by({{"missing"}}).empty());
+}
+BOOST_AUTO_TEST_CASE(data_frame_string_order) {
+    using type_collection = type_list<std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<std::string> sym_vec;
+    // short symbols, long strings sharing 8 and 16 byte prefixes, trailing and embedded zeros
+    for (int i = 0; i < 40000; i++) {
+        std::string s = "SYM" + std::to_string(i * 7919 % 997);
+        if (i % 3 == 0) s = "LONGPREFIX_" + std::string(i % 7, 'x') + s;
+        if (i % 5 == 0) s = "ABCDEFGHIJKLMNOP" + s;
+        if (i % 11 == 0) s.push_back('\0');
+        if (i % 13 == 0) s.insert(2, 1, '\0');
+        sym_vec.push_back(s);
+    }
+    sym_vec[5] = "";
+    sym_vec[6] = std::string(1, '\0');
+    sym_vec[7] = "\xff\xfe";
+    df.add_column("sym", sym_vec);
+    thread_pool pool(4);
+    auto desc = [](const std::string& l, const std::string& r) { return l > r; };
+    auto asc = [](const std::string& l, const std::string& r) { return l < r; };
+    BOOST_CHECK(df.order<std::string>("sym", pool) == parallel_argsort(sym_vec.data(), sym_vec.size(), desc, pool));
+    BOOST_CHECK(string_argsort(sym_vec.data(), sym_vec.size(), false, pool) == parallel_argsort(sym_vec.data(), sym_vec.size(), asc, pool));
+    auto small = string_argsort(sym_vec.data(), 100, false, pool);
+    BOOST_CHECK_EQUAL(small.front(), 5);
+    BOOST_CHECK_EQUAL(small[1], 6);
+    BOOST_CHECK_EQUAL(small.back(), 7);
+    BOOST_CHECK(df.order<std::string>("missing").empty());
+}
+BOOST_AUTO_TEST_CASE(data_frame_external_sort) {
+    using type_collection = type_list<long, double, std::string>::types;
+    // a fresh directory per run, so concurrent or leftover runs don't collide
+    auto dir = std::filesystem::temp_directory_path() /
+        ("data_frame_external_sort_test_" + std::to_string(std::random_device{}()));
+    BOOST_REQUIRE(std::filesystem::create_directory(dir));
+    std::vector<long> ts_vec;
+    std::vector<double> px_vec;
+    std::vector<std::string> sym_vec;
+    for (long i = 0; i < 30000; i++) {
+        ts_vec.push_back(i);
+        px_vec.push_back(i % 17 == 0 ? std::numeric_limits<double>::quiet_NaN() : (i * 7919 % 1009) / 4.0);
+        sym_vec.push_back("SYM" + std::to_string(i * 31 % 97));
+    }
+    data_frame all(type_collection{});
+    all.add_column("ts", ts_vec);
+    all.add_column("px", px_vec);
+    all.add_column("sym", sym_vec);
+    std::vector<sort_key> keys{{"sym"}, {"px", false, null_order::first}};
+    auto expected = all.order_by(keys);
+    external_sort_options options;
+    options.memory_budget = 64 << 10;
+    options.temp_dir = dir.string();
+    options.block_rows = 300;
+    thread_pool pool(4);
+    using sorter_t = external_sorter<long, double, std::string>;
+    sorter_t sorter(keys, options, pool);
+    for (long first = 0; first < 30000; first += 3000) {
+        data_frame chunk(type_collection{});
+        chunk.add_column("ts", std::vector<long>(ts_vec.begin() + first, ts_vec.begin() + first + 3000));
+        chunk.add_column("px", std::vector<double>(px_vec.begin() + first, px_vec.begin() + first + 3000));
+        chunk.add_column("sym", std::vector<std::string>(sym_vec.begin() + first, sym_vec.begin() + first + 3000));
+        BOOST_CHECK(sorter.push(chunk));
+    }
+    BOOST_CHECK(sorter.runs() > 1);
+    BOOST_CHECK(!std::filesystem::is_empty(dir));
+    // rows equal on both keys come back in push order, i.e. by ts
+    std::vector<long> merged;
+    auto collect = [&merged](data_frame<long, double, std::string>& df) {
+        BOOST_CHECK(df.get_cur_rows() <= 7000);
+        for (row_id_t i = 0; i < df.get_cur_rows(); i++) merged.push_back(df.get_c<long>("ts", i));
+    };
+    BOOST_CHECK(sorter.merge(collect, 7000));
+    BOOST_CHECK(merged == std::vector<long>(expected.begin(), expected.end()));
+    BOOST_CHECK(std::filesystem::is_empty(dir));
+    // small inputs are sorted in memory, the output file reads back in blocks
+    data_frame small(type_collection{});
+    small.add_column("ts", std::vector<long>(ts_vec.begin(), ts_vec.begin() + 800));
+    small.add_column("px", std::vector<double>(px_vec.begin(), px_vec.begin() + 800));
+    small.add_column("sym", std::vector<std::string>(sym_vec.begin(), sym_vec.begin() + 800));
+    BOOST_CHECK(sorter.push(small));
+    BOOST_CHECK_EQUAL(sorter.runs(), 0);
+    std::string out = (dir / "sorted.run").string();
+    BOOST_CHECK(sorter.merge_to_file(out));
+    std::vector<long> read_back;
+    size_t blocks = 0;
+    auto read_block = [&](data_frame<long, double, std::string>& df) {
+        ++blocks;
+        for (row_id_t i = 0; i < df.get_cur_rows(); i++) read_back.push_back(df.get_c<long>("ts", i));
+    };
+    BOOST_CHECK(sorter_t::for_each_chunk(out, read_block));
+    BOOST_CHECK_EQUAL(blocks, 3);
+    auto small_expected = small.order_by(keys);
+    BOOST_CHECK(read_back == std::vector<long>(small_expected.begin(), small_expected.end()));
+    data_frame other(type_collection{});
+    other.add_column("ts", std::vector<long>{1});
+    BOOST_CHECK(!sorter.push(other));
+    BOOST_CHECK(!sorter_t::for_each_chunk((dir / "missing.run").string(), read_block));
+    std::filesystem::remove_all(dir);
+}
+BOOST_AUTO_TEST_CASE(data_frame_sortedness) {
+    using type_collection = type_list<long, double, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<long> ts_vec;
+    std::vector<double> px_vec;
+    std::vector<std::string> sym_vec;
+    for (long i = 0; i < 10000; i++) {
+        ts_vec.push_back(i / 3);
+        px_vec.push_back(100.0 - i / 7);
+        sym_vec.push_back(std::to_string(i % 13));
+    }
+    df.add_column("ts", ts_vec);
+    df.add_column("px", px_vec);
+    df.add_column("sym", sym_vec);
+    BOOST_CHECK(df.get_sort_order("ts") == sort_order::ascending);
+    BOOST_CHECK(df.get_sort_order("px") == sort_order::descending);
+    BOOST_CHECK(df.get_sort_order("sym") == sort_order::none);
+    // range selects on sorted columns are contiguous runs found by binary search
+    auto by_ts = df.select<long>("ts", between(100L, 199L));
+    BOOST_CHECK(by_ts.get_selection().is_contiguous());
+    BOOST_CHECK_EQUAL(by_ts.get_cur_rows(), 300);
+    BOOST_CHECK_EQUAL(by_ts.get_selection()[0], 300);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", eq(5L)).get_cur_rows(), 3);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", lt(5L)).get_cur_rows(), 15);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", gt(3330L)).get_cur_rows(), 7);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", ge(3333L)).get_cur_rows(), 1);
+    BOOST_CHECK_EQUAL(df.select<double>("px", gt(99.0)).get_cur_rows(), df.mask<double>("px", gt(99.0)).count());
+    BOOST_CHECK_EQUAL(df.select<double>("px", le(-1000.0)).get_cur_rows(), df.mask<double>("px", le(-1000.0)).count());
+    BOOST_CHECK_EQUAL(df.select<double>("px", between(10.0, 20.0)).get_cur_rows(), df.mask<double>("px", between(10.0, 20.0)).count());
+    BOOST_CHECK_EQUAL(df.select<double>("px", eq(42.0)).get_cur_rows(), 7);
+    // a run past 2^16 rows keeps the row id width it needs once a further select stores its rows
+    data_frame wide(type_collection{});
+    std::vector<long> wide_ts(70000);
+    std::iota(wide_ts.begin(), wide_ts.end(), 0L);
+    wide.add_column("ts", wide_ts);
+    auto tail = wide.select<long>("ts", ge(65530L));
+    BOOST_CHECK(tail.get_selection().is_contiguous());
+    BOOST_CHECK_EQUAL(tail.get_selection().width(), 4);
+    BOOST_CHECK_EQUAL(tail.get_cur_rows(), 70000 - 65530);
+    tail.select<long>("ts", lt(65540L));
+    BOOST_CHECK(!tail.get_selection().is_contiguous());
+    BOOST_CHECK(tail.get_selection().to_vector() == std::vector<row_id_t>({65530, 65531, 65532, 65533, 65534,
+        65535, 65536, 65537, 65538, 65539}));
+    // appends keep the order only when they extend it
+    BOOST_CHECK(df.append_tuples(std::vector{std::make_tuple(3334L, -2000.0, "x"s)}, {"ts", "px", "sym"}));
+    BOOST_CHECK_EQUAL(df.get_cur_rows(), 10001);
+    BOOST_CHECK(df.get_sort_order("ts") == sort_order::ascending);
+    BOOST_CHECK(df.get_sort_order("px") == sort_order::descending);
+    BOOST_CHECK(df.append_tuples(std::vector{std::make_tuple(0L, -3000.0, "y"s)}, {"ts", "px", "sym"}));
+    BOOST_CHECK(df.get_sort_order("ts") == sort_order::none);
+    BOOST_CHECK(df.get_sort_order("px") == sort_order::descending);
+    BOOST_CHECK_EQUAL(df.select<long>("ts", eq(0L)).get_cur_rows(), 4);
+    BOOST_CHECK(!df.append_tuples(std::vector{std::make_tuple(0L, 1.0)}, {"ts", "px"}));
+    // sorted copies and ranges of sorted columns
+    auto by_sym = df.sort_copy<std::string>("sym");
+    BOOST_CHECK(by_sym.get_sort_order("sym") == sort_order::ascending);
+    BOOST_CHECK_EQUAL(by_sym.get_cur_rows(), df.get_cur_rows());
+    auto by_px = df.sort_copy<double>("px");
+    BOOST_CHECK(by_px.get_sort_order("px") == sort_order::ascending);
+    BOOST_CHECK_EQUAL(by_px.get_c<double>("px", 0), -3000.0);
+    BOOST_CHECK_EQUAL(by_sym.select<std::string>("sym", eq("7"s)).get_cur_rows(), df.mask<std::string>("sym", eq("7"s)).count());
+    auto head = df.copy_with_range(range(0, 100));
+    BOOST_CHECK(head.get_sort_order("px") == sort_order::descending);
+    BOOST_CHECK(head.get_sort_order("ts") == sort_order::none);
+    // writes through the frame drop the flag
+    df.get<double>("px", 0) = 0.0;
+    BOOST_CHECK(df.get_sort_order("px") == sort_order::none);
+}
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <boost/test/unit_test.hpp>
 #include "data_frame.hpp"
 #include <vector>
+#include <limits>
 #include <iostream>
 #include <tuple>
 #include <typeinfo>
@@ -80,4 +81,154 @@ BOOST_AUTO_TEST_CASE(data_frame_sort_with_index_test) {
     BOOST_CHECK_EQUAL(new_view.get<double>("double_vec", 0), 6.6);
     BOOST_CHECK_EQUAL(new_view.get<double>("double_vec", 1), 4.4);
 }
+BOOST_AUTO_TEST_CASE(data_frame_select_with_predicate_test) {
+    using type_collection = type_list<double, long, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<double> double_vec;
+    std::vector<long> long_vec;
+    std::vector<std::string> str_vec;
+    for (int i = 0; i < 1000; i++) {
+        double_vec.push_back((i * 37 % 101) / 10.0);
+        long_vec.push_back(i % 13);
+        str_vec.push_back(i % 2 ? "odd" : "even");
+    }
+    df.add_column("double_vec", double_vec);
+    df.add_column("long_vec", long_vec);
+    df.add_column("str_vec", str_vec);
+    auto m = df.mask<double>("double_vec", lt(2.5));
+    BOOST_CHECK_EQUAL(m.size(), 1000);
+    auto expected = df.select<double>("double_vec", [](double v) { return v < 2.5; });
+    BOOST_CHECK_EQUAL(m.count(), expected.get_cur_rows());
+    auto index = m.to_index();
+    for (auto i: index)
+        BOOST_CHECK(double_vec[i] < 2.5);
+    auto between_view = df.select<double>("double_vec", between(1.0, 2.0));
+    auto between_expected = df.select<double>("double_vec", [](double v) { return v >= 1.0 && v <= 2.0; });
+    BOOST_CHECK_EQUAL(between_view.get_cur_rows(), between_expected.get_cur_rows());
+    BOOST_CHECK_EQUAL(df.select<long>("long_vec", in({1L, 5L, 7L})).get_cur_rows(), 231);
+    BOOST_CHECK_EQUAL(df.select<long>("long_vec", eq(12L)).get_cur_rows(), 76);
+    BOOST_CHECK_EQUAL(df.select<long>("long_vec", le(0L)).get_cur_rows(), 77);
+    BOOST_CHECK_EQUAL(df.select<std::string>("str_vec", eq("odd"s)).get_cur_rows(), 500);
+    auto combined = df.mask<long>("long_vec", eq(0L)) & df.mask<std::string>("str_vec", eq("even"s));
+    BOOST_CHECK_EQUAL(df.create_view_with_mask(combined).get_cur_rows(), 39);
+}
+BOOST_AUTO_TEST_CASE(data_frame_select_with_expression_test) {
+    using type_collection = type_list<double, long, std::string>::types;
+    data_frame df(type_collection{});
+    std::vector<double> px;
+    std::vector<long> qty;
+    std::vector<std::string> side;
+    for (int i = 0; i < 5000; i++) {
+        px.push_back(i % 100 / 2.0);
+        qty.push_back(i % 1000);
+        side.push_back(i % 3 ? "buy" : "sell");
+    }
+    df.add_column("px", px);
+    df.add_column("qty", qty);
+    df.add_column("side", side);
+    auto expected = [&](int i) {
+        return (px[i] > 10 && qty[i] < 500 && side[i] == "buy") || !(qty[i] >= 10);
+    };
+    auto m = df.mask((col<double>("px") > 10 && col<long>("qty") < 500 && col<std::string>("side") == "buy"s) 
+                     || !(col<long>("qty") >= 10L));
+    size_t n = 0;
+    for (int i = 0; i < 5000; i++) {
+        BOOST_CHECK_EQUAL(m.test(i), expected(i));
+        n += expected(i);
+    }
+    BOOST_CHECK_EQUAL(m.count(), n);
+    auto view = df.select(col<long>("qty").between(100L, 199L) && col<double>("px").in({0.0, 1.5}));
+    BOOST_CHECK_EQUAL(view.get_cur_rows(), 10);
+    // chained selects narrow the rows of the view
+    auto chained = df.select<long>("qty", lt(500L));
+    BOOST_CHECK_EQUAL(chained.get_cur_rows(), 2500);
+    chained.select<double>("px", ge(25.0));
+    BOOST_CHECK_EQUAL(chained.get_cur_rows(), 1250);
+    chained.select(col<std::string>("side") == "sell"s);
+    BOOST_CHECK_EQUAL(chained.get_cur_rows(), df.select(col<long>("qty") < 500L && col<double>("px") >= 25.0 
+                                                        && col<std::string>("side") == "sell"s).get_cur_rows());
+    BOOST_CHECK_EQUAL(df.select(col<long>("missing") < 5L).get_cur_rows(), 0);
+}
+BOOST_AUTO_TEST_CASE(data_frame_parallel_select_test) {
+    using type_collection = type_list<double, long>::types;
+    data_frame df(type_collection{});
+    std::vector<double> double_vec;
+    std::vector<long> long_vec;
+    for (long i = 0; i < 200003; i++) {
+        double_vec.push_back((i * 7919 % 1000) / 10.0);
+        long_vec.push_back(i * 31 % 977);
+    }
+    df.add_column("double_vec", double_vec);
+    df.add_column("long_vec", long_vec);
+    thread_pool pool(4);
+    auto expected = df.mask<double>("double_vec", lt(12.5)).to_index();
+    auto view = df.parallel_select<double>("double_vec", lt(12.5), pool);
+    BOOST_CHECK_EQUAL(view.get_cur_rows(), expected.size());
+    auto lambda_view = df.parallel_select<long>("long_vec", [](long v) { return v % 2 == 0; }, pool);
+    BOOST_CHECK_EQUAL(lambda_view.get_cur_rows(), df.select<long>("long_vec", [](long v) { return v % 2 == 0; }).get_cur_rows());
+    auto e = col<double>("double_vec") >= 50.0 && col<long>("long_vec") < 100L;
+    BOOST_CHECK_EQUAL(df.parallel_select(e, pool).get_cur_rows(), df.mask(e).count());
+    // the compacted index is ordered and identical for any number of threads
+    auto eval = [&](size_t first, size_t n, selection_mask::word_type* out) {
+        evaluate_predicate(&double_vec[first], n, lt(12.5), out);
+    };
+    thread_pool single(1);
+    auto index1 = parallel_compact(double_vec.size(), eval, single);
+    auto index4 = parallel_compact(double_vec.size(), eval, pool);
+    BOOST_CHECK(index1 == expected);
+    BOOST_CHECK(index4 == expected);
+}
+BOOST_AUTO_TEST_CASE(data_frame_view_selection_width_test) {
+    using type_collection = type_list<double, long>::types;
+    data_frame df(type_collection{});
+    std::vector<long> long_vec(70000);
+    for (long i = 0; i < 70000; i++) long_vec[i] = i;
+    df.add_column("long_vec", long_vec);
+    // 16-bit row ids address the first 65536 rows, the 70000-row frame needs 32 bits
+    auto small = df.create_view_with_range(range(0, 100));
+    auto view = df.select<long>("long_vec", ge(65530L));
+    BOOST_CHECK_EQUAL(view.get_selection().width(), 4);
+    BOOST_CHECK_EQUAL(view.get_selection()[0], 65530);
+    BOOST_CHECK_EQUAL(view.get_cur_rows(), 70000 - 65530);
+    view.select<long>("long_vec", lt(65540L));
+    BOOST_CHECK_EQUAL(view.get_cur_rows(), 10);
+    data_frame small_df(type_collection{});
+    small_df.add_column("long_vec", std::vector<long>{3, 1, 2});
+    auto sorted = small_df.sort<long>("long_vec");
+    BOOST_CHECK_EQUAL(sorted.get_selection().width(), 2);
+    BOOST_CHECK(sorted.get_selection().to_vector() == (std::vector<row_id_t>{0, 2, 1}));
+    // row ids above 2^32 widen the storage instead of truncating
+    selection_vector rows(small_df.get_cur_rows());
+    rows.push_back(7);
+    rows.push_back(row_id_t(1) << 33);
+    BOOST_CHECK_EQUAL(rows.width(), 8);
+    BOOST_CHECK_EQUAL(rows[0], 7);
+    BOOST_CHECK_EQUAL(rows[1], row_id_t(1) << 33);
+    BOOST_CHECK_EQUAL(small.get_cur_rows(), 100);
+}
+BOOST_AUTO_TEST_CASE(data_frame_top_k_test) {
+    using type_collection = type_list<double, long>::types;
+    data_frame df(type_collection{});
+    std::vector<double> double_vec;
+    std::vector<long> long_vec;
+    for (long i = 0; i < 100000; i++) {
+        double_vec.push_back(i % 97 == 0 ? std::numeric_limits<double>::quiet_NaN() : (i * 7919 % 5003) / 3.0);
+        long_vec.push_back(i * 31 % 977);
+    }
+    df.add_column("double_vec", double_vec);
+    df.add_column("long_vec", long_vec);
+    thread_pool pool(4);
+    auto largest = df.nlargest<long>("long_vec", 100, pool);
+    auto order = df.order<long>("long_vec", pool);
+    BOOST_CHECK_EQUAL(largest.get_cur_rows(), 100);
+    BOOST_CHECK(largest.get_selection().to_vector() == std::vector<row_id_t>(order.begin(), order.begin() + 100));
+    auto smallest = df.nsmallest<double>("double_vec", 50, pool).get_selection().to_vector();
+    auto asc = radix_argsort(double_vec.data(), double_vec.size(), false, pool);
+    BOOST_CHECK(smallest == std::vector<row_id_t>(asc.begin(), asc.begin() + 50));
+    // a custom ordering, and k larger than the frame
+    auto by_mod = df.top_k<long>("long_vec", 10, [](long l, long r) { return l % 10 < r % 10; }, pool);
+    by_mod.get_selection().for_each([&](row_id_t row) { BOOST_CHECK_EQUAL(long_vec[row] % 10, 0); });
+    BOOST_CHECK_EQUAL(df.nlargest<double>("double_vec", 200000).get_cur_rows(), 100000);
+    BOOST_CHECK_EQUAL(df.nlargest<double>("missing", 10).get_cur_rows(), 0);
+}
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file